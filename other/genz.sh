@@ -1,14 +1,16 @@
-pgm=../src/testpack_digitalnet
+pgm=../src/genz_sweep
 gnz=$1
 sdim=$2
-declare -a dnnames=("NX" "Sobol" "NXLW" "SobolLW")
-declare -a dnindex=(0 1 3 4)
+threads=${3:-$(nproc)}
 declare -a gnznames=("Oscillatory" "ProductPeak" "CornerPeak" "Gaussian" \
                     "C0Function" "Discontinuous")
 
-for ((i=0;i<4;i++)) do
-#    output="${gnznames[${gnz}-1]}${dnnames[$i]}RMSE.$sdim.txt"
-    output="${gnznames[${gnz}-1]}${dnnames[$i]}.$sdim.txt"
-#    $pgm -s $sdim -m 10 -M 18 -S 1 -g $gnz -d ${dnindex[$i]} -r100 > $output
-    $pgm -s $sdim -m 10 -M 18 -S 1 -g $gnz -d ${dnindex[$i]} > $output
-done
+# one process for all nets, lines are split into files by net name.
+# NX:0 Sobol:1 NXLW:3 SobolLW:4
+gn=${gnznames[${gnz}-1]}
+#$pgm -d 0,1,3,4 -g $gnz -s $sdim -m 10 -M 18 -S 1 -r100 -j $threads | \
+#    sort -t, -k1,1 -k3n | awk -F, -v gn=$gn -v sdim=$sdim \
+#    '!/^#/ {print $3 "," $6 "," $7 > (gn $1 "RMSE." sdim ".txt")}'
+$pgm -d 0,1,3,4 -g $gnz -s $sdim -m 10 -M 18 -S 1 -j $threads | \
+    sort -t, -k1,1 -k3n | awk -F, -v gn=$gn -v sdim=$sdim \
+    '!/^#/ {print $3 "," $6 "," $7 > (gn $1 "." sdim ".txt")}'
@@ -1,141 +1,12 @@
 #include "Genz.hpp"
+#include "genz_simd.h"
+#include "corner_expect.h"
 #include <cmath>
+#include <vector>
 
 using namespace std;
 
 namespace {
-    //*
-//
-//  Purpose:
-//
-//    TUPLE_NEXT computes the next element of a tuple space.
-//
-//  Discussion:
-//
-//    The elements are N vectors.  Each entry is constrained to lie
-//    between M1 and M2.  The elements are produced one at a time.
-//    The first element is
-//      (M1,M1,...,M1),
-//    the second element is
-//      (M1,M1,...,M1+1),
-//    and the last element is
-//      (M2,M2,...,M2)
-//    Intermediate elements are produced in lexicographic order.
-//
-//  Example:
-//
-//    N = 2, M1 = 1, M2 = 3
-//
-//    INPUT        OUTPUT
-//    -------      -------
-//    Rank  X      Rank   X
-//    ----  ---    -----  ---
-//    0     * *    1      1 1
-//    1     1 1    2      1 2
-//    2     1 2    3      1 3
-//    3     1 3    4      2 1
-//    4     2 1    5      2 2
-//    5     2 2    6      2 3
-//    6     2 3    7      3 1
-//    7     3 1    8      3 2
-//    8     3 2    9      3 3
-//    9     3 3    0      0 0
-//
-//  Modified:
-//
-//    29 April 2003
-//
-//  Author:
-//
-//    John Burkardt
-//
-//  Parameters:
-//
-//    Input, int M1, M2, the minimum and maximum entries.
-//
-//    Input, int N, the number of components.
-//
-//    Input/output, int *RANK, counts the elements.
-//    On first call, set RANK to 0.  Thereafter, the output value of RANK
-//    will indicate the order of the element returned.  When there are no
-//    more elements, RANK will be returned as 0.
-//
-//    Input/output, int X[N], on input the previous tuple.
-//    On output, the next tuple.
-//
-    int tuple_next( int m1, int m2, int n, int rank, int x[])
-    {
-        if ( m2 < m1 ) {
-            return 0;
-        }
-        if ( rank <= 0 ) {
-            for (int i = 0; i < n; i++) {
-                x[i] = m1;
-            }
-            return 1;
-        }
-        rank = rank + 1;
-        int i = n - 1;
-
-        for ( ; ; ) {
-            if ( x[i] < m2 ) {
-                x[i] = x[i] + 1;
-                break;
-            }
-            x[i] = m1;
-            if ( i == 0 ) {
-                rank = 0;
-                for (int j = 0; j < n; j++ ) {
-                    x[j] = m1;
-                }
-                break;
-            }
-            i = i - 1;
-        }
-        return rank;
-    }
-
-    //*************************************************************************
-//
-//  Purpose:
-//
-//    I4VEC_SUM sums the entries of an I4VEC.
-//
-//  Example:
-//
-//    Input:
-//
-//      A = ( 1, 2, 3, 4 )
-//
-//    Output:
-//
-//      I4VEC_SUM = 10
-//
-//  Modified:
-//
-//    26 May 1999
-//
-//  Author:
-//
-//    John Burkardt
-//
-//  Parameters:
-//
-//    Input, int N, the number of entries in the vector.
-//
-//    Input, int A[N], the vector to be summed.
-//
-//    Output, int I4VEC_SUM, the sum of the entries of A.
-//
-    int i4vec_sum ( int n, int a[] )
-    {
-        int sum = 0;
-        for (int i = 0; i < n; i++ ) {
-            sum = sum + a[i];
-        }
-        return sum;
-    }
-
 //****************************************************************************80
 //
 //  Purpose:
@@ -330,6 +201,28 @@ namespace {
 }
 
 namespace GenzNS {
+    void GenzFunction::evaluate(int ndim, int n, const double z[],
+                                const double alpha[], const double beta[],
+                                double value[]) const
+    {
+        for (int i = 0; i < n; i++) {
+            value[i] = (*this)(ndim, &z[i * ndim], alpha, beta);
+        }
+    }
+
+    void GenzFunction::evaluateSoA(int ndim, int n, const double z[],
+                                   const double alpha[], const double beta[],
+                                   double value[]) const
+    {
+        vector<double> x(n * ndim);
+        for (int j = 0; j < ndim; j++) {
+            for (int i = 0; i < n; i++) {
+                x[i * ndim + j] = z[j * n + i];
+            }
+        }
+        evaluate(ndim, n, &x[0], alpha, beta, value);
+    }
+
     double Oscillatory::operator()(int ndim, const double z[],
                                    const double *,
                                    const double beta[]) const
@@ -342,38 +235,42 @@ namespace GenzNS {
         return cos(total);
     }
 
+    void Oscillatory::evaluate(int ndim, int n, const double z[],
+                               const double *, const double beta[],
+                               double value[]) const
+    {
+        const double c = 2.0 * M_PI * beta[0];
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
+            double s = 0.0;
+            for (int j = 0; j < ndim; j++) {
+                s += x[j];
+            }
+            value[i] = cos(c + s);
+        }
+    }
+
+    void Oscillatory::evaluateSoA(int ndim, int n, const double z[],
+                                  const double *, const double beta[],
+                                  double value[]) const
+    {
+        GenzBinding genz;
+        genz.bindUnitWeights(ndim, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void Oscillatory::bind(int ndim, const double *, const double beta[])
+    {
+        binding.bindUnitWeights(ndim, beta);
+    }
+
     double Oscillatory::integral(int ndim, const double *,
                                  const double *,
                                  const double alpha[],
                                  const double beta[])
         const
     {
-        double value = 0.0;
-        int rank = 0;
-        int ic[ndim];
-        for (;;) {
-            rank = tuple_next(0, 1, ndim, rank, ic);
-            if ( rank == 0 ) {
-                break;
-            }
-            double total = 2.0 * M_PI * beta[0];
-            for (int j = 0; j < ndim; j++ ) {
-                if ( ic[j] != 1 ) {
-                    total = total + alpha[j];
-                }
-            }
-            int isum = i4vec_sum ( ndim, ic );
-            double s = 1 + 2 * ( ( isum / 2 ) * 2 - isum );
-            if ( ( ndim % 2 ) == 0 ) {
-                value = value + s * cos ( total );
-            } else {
-                value = value + s * sin ( total );
-            }
-        }
-        if ( 1 < ( ndim % 4 ) ) {
-            value = - value;
-        }
-        return value;
+        return oscillatory_expect(ndim, 2.0 * M_PI * beta[0], alpha);
     }
 
     string Oscillatory::name() const
@@ -408,6 +305,38 @@ namespace GenzNS {
         return 1.0 / total;
     }
 
+    void ProductPeak::evaluate(int ndim, int n, const double z[],
+                               const double alpha[], const double beta[],
+                               double value[]) const
+    {
+        vector<double> inv(ndim);
+        for (int j = 0; j < ndim; j++) {
+            inv[j] = 1.0 / pow(alpha[j], 2);
+        }
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
+            double total = 1.0;
+            for (int j = 0; j < ndim; j++) {
+                const double d = x[j] - beta[j];
+                total = total * (inv[j] + d * d);
+            }
+            value[i] = 1.0 / total;
+        }
+    }
+
+    void ProductPeak::evaluateSoA(int ndim, int n, const double z[],
+                                  const double alpha[], const double beta[],
+                                  double value[]) const
+    {
+        GenzBinding genz(2, ndim, alpha, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void ProductPeak::bind(int ndim, const double alpha[], const double beta[])
+    {
+        binding.bind(2, ndim, alpha, beta);
+    }
+
     double ProductPeak::integral(int ndim, const double *,
                                  const double *,
                                  const double alpha[],
@@ -454,35 +383,49 @@ namespace GenzNS {
         return 1.0 / pow ( total, ndim + 1 );
     }
 
-    double CornerPeak::integral(int ndim, const double *,
-                                const double *,
-                                const double alpha[],
-                                const double *) const
+    void CornerPeak::evaluate(int ndim, int n, const double z[],
+                              const double alpha[], const double beta[],
+                              double value[]) const
     {
-        double value = 0.0;
-        double sgndm = 1.0;
-        for (int j = 1; j <= ndim; j++ ) {
-            sgndm = - sgndm / static_cast<double>( j );
+        // corner of the peak is selected by beta, same for all points
+        vector<char> upper(ndim);
+        for (int j = 0; j < ndim; j++) {
+            upper[j] = !(beta[j] < 0.5);
         }
-
-        int rank = 0;
-        int ic[ndim];
-        for ( ; ; ) {
-            rank = tuple_next ( 0, 1, ndim, rank, ic );
-            if ( rank == 0 ) {
-                break;
-            }
+        const int e = ndim + 1;
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
             double total = 1.0;
-            for (int j = 0; j < ndim; j++ ) {
-                if ( ic[j] != 1 ) {
-                    total = total + alpha[j];
+            for (int j = 0; j < ndim; j++) {
+                if (upper[j]) {
+                    total = total + alpha[j] - x[j];
+                } else {
+                    total = total + x[j];
                 }
             }
-            int isum = i4vec_sum ( ndim, ic );
-            double s = 1 + 2 * ( ( isum / 2 ) * 2 - isum );
-            value = value + static_cast<double>(s) / total;
+            value[i] = 1.0 / pow(total, e);
         }
-        return value * sgndm;
+    }
+
+    void CornerPeak::evaluateSoA(int ndim, int n, const double z[],
+                                 const double alpha[], const double beta[],
+                                 double value[]) const
+    {
+        GenzBinding genz(3, ndim, alpha, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void CornerPeak::bind(int ndim, const double alpha[], const double beta[])
+    {
+        binding.bind(3, ndim, alpha, beta);
+    }
+
+    double CornerPeak::integral(int ndim, const double *,
+                                const double *,
+                                const double alpha[],
+                                const double *) const
+    {
+        return cornerpeak_expect(ndim, alpha);
     }
 
     string CornerPeak::name() const
@@ -516,6 +459,34 @@ namespace GenzNS {
         return exp ( - total );
     }
 
+    void Gaussian::evaluate(int ndim, int n, const double z[],
+                            const double alpha[], const double beta[],
+                            double value[]) const
+    {
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
+            double total = 0.0;
+            for (int j = 0; j < ndim; j++) {
+                const double t = alpha[j] * (x[j] - beta[j]);
+                total = total + t * t;
+            }
+            value[i] = exp(- r8_min(total, 100.0));
+        }
+    }
+
+    void Gaussian::evaluateSoA(int ndim, int n, const double z[],
+                               const double alpha[], const double beta[],
+                               double value[]) const
+    {
+        GenzBinding genz(4, ndim, alpha, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void Gaussian::bind(int ndim, const double alpha[], const double beta[])
+    {
+        binding.bind(4, ndim, alpha, beta);
+    }
+
     double Gaussian::integral(int ndim, const double *,
                               const double *,
                               const double alpha[],
@@ -558,6 +529,33 @@ namespace GenzNS {
         return exp ( - total );
     }
 
+    void C0Function::evaluate(int ndim, int n, const double z[],
+                              const double alpha[], const double beta[],
+                              double value[]) const
+    {
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
+            double total = 0.0;
+            for (int j = 0; j < ndim; j++) {
+                total = total + alpha[j] * fabs(x[j] - beta[j]);
+            }
+            value[i] = exp(- total);
+        }
+    }
+
+    void C0Function::evaluateSoA(int ndim, int n, const double z[],
+                                 const double alpha[], const double beta[],
+                                 double value[]) const
+    {
+        GenzBinding genz(5, ndim, alpha, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void C0Function::bind(int ndim, const double alpha[], const double beta[])
+    {
+        binding.bind(5, ndim, alpha, beta);
+    }
+
     double C0Function::integral(int ndim, const double *,
                                 const double *,
                                 const double alpha[],
@@ -611,6 +609,41 @@ namespace GenzNS {
         return value;
     }
 
+    void Discontinuous::evaluate(int ndim, int n, const double z[],
+                                 const double alpha[], const double beta[],
+                                 double value[]) const
+    {
+        for (int i = 0; i < n; i++) {
+            const double *x = &z[i * ndim];
+            bool test = false;
+            for (int j = 0; j < ndim; j++) {
+                if (beta[j] < x[j]) {
+                    test = true;
+                    break;
+                }
+            }
+            if (test) {
+                value[i] = 0.0;
+            } else {
+                value[i] = exp(r8vec_dot(ndim, alpha, x));
+            }
+        }
+    }
+
+    void Discontinuous::evaluateSoA(int ndim, int n, const double z[],
+                                    const double alpha[], const double beta[],
+                                    double value[]) const
+    {
+        GenzBinding genz(6, ndim, alpha, beta);
+        genz.evaluate(n, z, value);
+    }
+
+    void Discontinuous::bind(int ndim, const double alpha[],
+                             const double beta[])
+    {
+        binding.bind(6, ndim, alpha, beta);
+    }
+
     double Discontinuous::integral(int ndim, const double *, const double *,
                                    const double alpha[],
                                    const double beta[]) const
@@ -6,8 +6,18 @@
 #include <cmath>
 #include <iostream>
 #include <iomanip>
+#include <vector>
+#include <algorithm>
+#include "genz_simd.h"
+#include "workspace.hpp"
 
 namespace GenzNS {
+    /**
+     * number of points evaluated by one call of GenzFunction::evaluate
+     * in integral().
+     */
+    const int block_size = 256;
+
     class GenzFunction {
     public:
         virtual ~GenzFunction(){};
@@ -15,6 +25,39 @@ namespace GenzNS {
                                   const double z[],
                                   const double alpha[],
                                   const double beta[]) const = 0;
+        /**
+         * evaluate n points at once.
+         * @param ndim dimension
+         * @param n number of points
+         * @param z points, point-major, z[i * ndim + j] is j-th
+         * coordinate of i-th point
+         * @param alpha parameter
+         * @param beta parameter
+         * @param value output, value[i] is function value of i-th point
+         */
+        virtual void evaluate(int ndim, int n, const double z[],
+                              const double alpha[], const double beta[],
+                              double value[]) const;
+        /**
+         * evaluate n points given in structure-of-arrays layout,
+         * z[j * n + i] is j-th coordinate of i-th point.
+         * Integrands in this file use the SIMD kernels of genz_simd.h.
+         */
+        virtual void evaluateSoA(int ndim, int n, const double z[],
+                                 const double alpha[], const double beta[],
+                                 double value[]) const;
+        /**
+         * precompute what depends only on alpha and beta for
+         * evaluateBound().
+         */
+        virtual void bind(int ndim, const double alpha[],
+                          const double beta[]) = 0;
+        /**
+         * the same as evaluateSoA() with alpha and beta given to bind().
+         */
+        void evaluateBound(int n, const double z[], double value[]) const {
+            binding.evaluate(n, z, value);
+        }
         virtual double integral(int ndim,
                                 const double a[],
                                 const double b[],
@@ -24,12 +67,21 @@ namespace GenzNS {
         virtual double difficulty() const = 0;
         virtual void setTestParams(int dim, double a[], double b[],
                                    double alpha[], double beta[]) const = 0;
+    protected:
+        GenzBinding binding;
     };
 
-    class Oscillatory: public GenzFunction {
+    class Oscillatory final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -38,10 +90,17 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    class ProductPeak: public GenzFunction {
+    class ProductPeak final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -50,10 +109,17 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    class CornerPeak: public GenzFunction {
+    class CornerPeak final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -62,10 +128,17 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    class Gaussian: public GenzFunction {
+    class Gaussian final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -74,10 +147,17 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    class C0Function: public GenzFunction {
+    class C0Function final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -86,10 +166,17 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    class Discontinuous: public GenzFunction {
+    class Discontinuous final: public GenzFunction {
     public:
         double operator()(int ndim, const double z[],
                           const double alpha[], const double beta[]) const;
+        void evaluate(int ndim, int n, const double z[],
+                      const double alpha[], const double beta[],
+                      double value[]) const;
+        void evaluateSoA(int ndim, int n, const double z[],
+                         const double alpha[], const double beta[],
+                         double value[]) const;
+        void bind(int ndim, const double alpha[], const double beta[]);
         double integral(int ndim, const double a[], const double b[],
                         const double alpha[], const double beta[]) const;
         std::string name() const;
@@ -98,15 +185,23 @@ namespace GenzNS {
                            double alpha[], double beta[]) const;
     };
 
-    template<typename D>
-    double integral(const GenzFunction& func, D& digitalNet, int count, int dim,
+    /**
+     * error of integration of func by count points of digitalNet.
+     * F is GenzFunction or one of the final classes above, for which
+     * all calls are resolved at compile time.
+     */
+    template<typename F, typename D>
+    double integral(F& func, D& digitalNet, int count, int dim,
                     const double alpha[], const double beta[])
     {
         using namespace std;
-        double a[dim];
-        double b[dim];
-        double alpha1[dim];
-        double beta1[dim];
+        // reused by the calls of the thread, no allocation after the first
+        static thread_local MCQMCIntegration::Workspace work;
+        work.reset();
+        double *a = work.alloc(dim);
+        double *b = work.alloc(dim);
+        double *alpha1 = work.alloc(dim);
+        double *beta1 = work.alloc(dim);
         double total = 0;
         for (int i = 0; i < dim; i++) {
             a[i] = 0;
@@ -121,6 +216,7 @@ namespace GenzNS {
             alpha1[i] = alpha1[i] / dfact;
         }
         func.setTestParams(dim, a, b, alpha1, beta1);
+        func.bind(dim, alpha1, beta1);
 #if defined(DEBUG)
         cout << "after setTestParams" << endl;
         cout << "a = (";
@@ -146,10 +242,22 @@ namespace GenzNS {
 #endif
         //digitalNet.pointInitialize();
         double sum = 0;
+        double *points = work.alloc(static_cast<size_t>(block_size) * dim);
+        double *values = work.alloc(block_size);
         //for (int i = 1; i < count; i++) {
-        for (int i = 0; i < count; i++) {
-            sum += func(dim, digitalNet.getPoint(), alpha1, beta1);
-            digitalNet.nextPoint();
+        for (int i = 0; i < count; i += block_size) {
+            int n = std::min(block_size, count - i);
+            for (int k = 0; k < n; k++) {
+                const double *tuple = digitalNet.getPoint();
+                for (int j = 0; j < dim; j++) {
+                    points[j * n + k] = tuple[j];
+                }
+                digitalNet.nextPoint();
+            }
+            func.evaluateBound(n, points, values);
+            for (int k = 0; k < n; k++) {
+                sum += values[k];
+            }
         }
         sum = sum / count;
         double expected = func.integral(dim, a, b, alpha1, beta1);
@@ -160,8 +268,8 @@ namespace GenzNS {
         return abs(expected - sum);
     }
 
-    template<typename D>
-    void integralAll(const GenzFunction& func, D& digitalNet,
+    template<typename F, typename D>
+    void integralAll(F& func, D& digitalNet,
                      int start_m, int stop_m, int dim,
                      const double alpha[], const double beta[])
     {
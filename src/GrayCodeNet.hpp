@@ -0,0 +1,185 @@
+#pragma once
+#ifndef GRAYCODENET_HPP
+#define GRAYCODENET_HPP
+
+#include <inttypes.h>
+#include <vector>
+#include <random>
+#include <MCQMCIntegration/DigitalNet.h>
+
+namespace MCQMCIntegration {
+
+    /**
+     * Cursor of a digital net which can be positioned at any point.
+     *
+     * i-th point is the XOR of the rows of the generating matrices
+     * selected by the bits of the gray code i ^ (i >> 1), so that
+     * nextPoint() needs one XOR of a row per coordinate, and
+     * setIndex() needs at most m.
+     * Unlike DigitalNet, copies of GrayCodeNet are independent cursors
+     * sharing the same point set and digital shift, which is used to
+     * split the point set among threads.
+     *
+     * The 64-bit integer coordinates are available by getPointBase() and
+     * fillBase(), and conversion to double is done only when getPoint()
+     * is called.
+     */
+    class GrayCodeNet {
+    public:
+        GrayCodeNet(DigitalNet<uint64_t>& dn) {
+            s = dn.getS();
+            m = dn.getM();
+            base.resize(static_cast<size_t>(s) * m);
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < s; j++) {
+                    base[i * s + j] = dn.getBase(i, j);
+                }
+            }
+            initialize();
+        }
+        /**
+         * @param s dimension of R
+         * @param m dimension of F2
+         * @param mat s * m rows of generating matrices,
+         * mat[i * s + j] is i-th row of j-th coordinate.
+         */
+        GrayCodeNet(int s, int m, const uint64_t mat[]) {
+            this->s = s;
+            this->m = m;
+            base.assign(mat, mat + static_cast<size_t>(s) * m);
+            initialize();
+        }
+        void setSeed(uint64_t seed) {
+            mt.seed(seed);
+        }
+        /**
+         * if value is true, pointInitialize() chooses new digital shift.
+         */
+        void setDigitalShift(bool value) {
+            digitalShift = value;
+        }
+        void pointInitialize() {
+            for (int j = 0; j < s; j++) {
+                if (digitalShift) {
+                    shift[j] = mt();
+                } else {
+                    shift[j] = 0;
+                }
+            }
+            setIndex(0);
+        }
+        /**
+         * move to idx-th point, digital shift is not changed.
+         */
+        void setIndex(uint64_t idx) {
+            if (m < 64) {
+                idx &= (UINT64_C(1) << m) - 1;
+            }
+            index = idx;
+            uint64_t gray = idx ^ (idx >> 1);
+            for (int j = 0; j < s; j++) {
+                point_base[j] = shift[j];
+            }
+            for (int i = 0; gray != 0; i++, gray >>= 1) {
+                if (gray & 1) {
+                    const uint64_t *row = &base[i * s];
+                    for (int j = 0; j < s; j++) {
+                        point_base[j] ^= row[j];
+                    }
+                }
+            }
+            converted = false;
+        }
+        void nextPoint() {
+            index++;
+            if (m < 64 && index == (UINT64_C(1) << m)) {
+                setIndex(0);
+                return;
+            }
+            const uint64_t *row = &base[ctz(index) * s];
+            for (int j = 0; j < s; j++) {
+                point_base[j] ^= row[j];
+            }
+            converted = false;
+        }
+        const double * getPoint() const {
+            if (!converted) {
+                convert();
+            }
+            return &point[0];
+        }
+        /**
+         * 64-bit integer coordinates of the current point,
+         * the point in [0, 1)^s is getPointBase()[j] / 2^64.
+         */
+        const uint64_t * getPointBase() const {
+            return &point_base[0];
+        }
+        /**
+         * copy the integer coordinates of the current point and following
+         * n - 1 points to out, and move to the point after them.
+         * @param out output, out[k * s + j] is j-th coordinate of k-th
+         * point, size should be n * s or more.
+         * @param n number of points
+         */
+        void fillBase(uint64_t out[], int n) {
+            for (int k = 0; k < n; k++) {
+                uint64_t *p = &out[static_cast<size_t>(k) * s];
+                for (int j = 0; j < s; j++) {
+                    p[j] = point_base[j];
+                }
+                nextPoint();
+            }
+        }
+        uint64_t getIndex() const {
+            return index;
+        }
+        int getS() const {
+            return s;
+        }
+        int getM() const {
+            return m;
+        }
+    private:
+        int s;
+        int m;
+        bool digitalShift;
+        uint64_t index;
+        std::vector<uint64_t> base;
+        std::vector<uint64_t> shift;
+        std::vector<uint64_t> point_base;
+        mutable std::vector<double> point;
+        mutable bool converted;
+        std::mt19937_64 mt;
+
+        void initialize() {
+            digitalShift = false;
+            shift.assign(s, 0);
+            point_base.assign(s, 0);
+            point.assign(s, 0.0);
+            setIndex(0);
+        }
+        // the same conversion as RandomNet
+        void convert() const {
+            for (int j = 0; j < s; j++) {
+                point[j] = (point_base[j] >> 11) * (1.0/9007199254740992.0)
+                    + (1.0/18014398509481984.0);
+            }
+            converted = true;
+        }
+        static int ctz(uint64_t x) {
+#if defined(__GNUC__)
+            return __builtin_ctzll(x);
+#else
+            int c = 0;
+            while ((x & 1) == 0) {
+                x >>= 1;
+                c++;
+            }
+            return c;
+#endif
+        }
+    };
+}
+
+#endif // GRAYCODENET_HPP
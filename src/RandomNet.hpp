@@ -6,6 +6,11 @@
 
 namespace MCQMCIntegration {
 
+    /**
+     * Monte Carlo points by mt19937_64. The 64-bit numbers of
+     * block_points points are generated by one mt19937_64::fill(), and
+     * the points are taken from the block.
+     */
     class RandomNet {
     public:
         RandomNet(int s, uint32_t seed) {
@@ -13,10 +18,19 @@ namespace MCQMCIntegration {
             mt.seed(seed);
             mask = 0;
             mask = ~mask;
+            block_points = block_values / s;
+            if (block_points < 1) {
+                block_points = 1;
+            }
+            block = new uint64_t[block_points * s];
+            next_point = block_points;
             point = new double[s];
+            point_base = new uint64_t[s];
         }
         ~RandomNet() {
+            delete[] block;
             delete[] point;
+            delete[] point_base;
         }
         void setMask(int m) {
             mask = 0;
@@ -30,22 +44,67 @@ namespace MCQMCIntegration {
             nextPoint();
         }
         void nextPoint() {
+            const uint64_t *x = nextBlockPoint();
+            const double offset = 1.0 / 18014398509481984.0; // 2^-54
             for (int i = 0; i < s; i++) {
-                point[i] = ((mt.getUint64() & mask) >> 11)
+                point_base[i] = x[i] & mask;
+                point[i] = (point_base[i] >> 11)
                     * (1.0/9007199254740992.0)
-                    + pow(2.0, -54);
+                    + offset;
             }
         }
+        /**
+         * masked 64-bit integers from which getPoint() is made.
+         */
+        const uint64_t * getPointBase() const {
+            return point_base;
+        }
+        /**
+         * copy the integers of the current point and following n - 1
+         * points to out, point-major, and move to the point after them.
+         * No conversion to double is done for the copied points.
+         */
+        void fillBase(uint64_t out[], int n) {
+            if (n <= 0) {
+                return;
+            }
+            for (int i = 0; i < s; i++) {
+                out[i] = point_base[i];
+            }
+            uint64_t *p = out + s;
+            for (int k = 1; k < n; k++) {
+                const uint64_t *x = nextBlockPoint();
+                for (int i = 0; i < s; i++) {
+                    *p++ = x[i] & mask;
+                }
+            }
+            nextPoint();
+        }
         void setDigitalShift(bool) {
         }
         int getS() {
             return s;
         }
     private:
+        enum {block_values = 1024};
         int s;
+        int block_points;
+        int next_point;
         uint64_t mask;
+        uint64_t * block;
         double * point;
+        uint64_t * point_base;
         mt19937_64 mt;
+
+        // unmasked numbers of the next point, the block is filled when
+        // all of its points are used.
+        const uint64_t * nextBlockPoint() {
+            if (next_point >= block_points) {
+                mt.fill(block, static_cast<size_t>(block_points) * s);
+                next_point = 0;
+            }
+            return block + static_cast<size_t>(next_point++) * s;
+        }
     };
 }
 
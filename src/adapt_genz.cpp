@@ -0,0 +1,255 @@
+#include <cerrno>
+#include <getopt.h>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include "testpack.h"
+#include "genz_simd.h"
+#include "make_parameters.h"
+#include "adapt_parallel.h"
+#include "workspace.hpp"
+
+using namespace std;
+using namespace MCQMCIntegration;
+
+/*
+ * integrate genz functions by adapt_parallel() with maximum 2^m
+ * function evaluations, to compare with testpack_digitalnet which uses
+ * 2^m points of digital nets. The integrands are evaluated by the same
+ * kernels as testpack_digitalnet.
+ */
+namespace {
+    struct cmd_opt_t {
+        uint32_t s_dim;
+        uint32_t start_m;
+        uint32_t end_m;
+        uint32_t seed;
+        int genz_no;
+        int original;
+        double difficulty;
+        double rel_tol;
+        int threads;
+        int regions;
+        bool verbose;
+    };
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
+    void cmd_message(const string& pgm);
+}
+
+int main(int argc, char *argv[])
+{
+    cmd_opt_t opt;
+    if (!parse_opt(opt, argc, argv)) {
+        return -1;
+    }
+    int s = opt.s_dim;
+    Workspace work;
+    double *a = work.alloc(s);
+    double *b = work.alloc(s);
+    double *alpha = work.alloc(s);
+    double *beta = work.alloc(s);
+    makeParameter(opt.genz_no, s, opt.seed, opt.original,
+                  a, b, alpha, beta, opt.verbose, opt.difficulty);
+    double expected = genz_integral(opt.genz_no, s, a, b, alpha, beta);
+    GenzBinding genz(opt.genz_no, s, alpha, beta);
+    adapt_block_function functn = [&genz](int n, const double z[],
+                                          double value[]) {
+        genz.evaluate(n, z, value);
+    };
+    int points = adapt_rule_points(s);
+    cout << "#" << genz_name(opt.genz_no) << endl;
+    cout << "#s = " << dec << s << endl;
+    cout << "#rule points = " << points << endl;
+    cout << "#rel_tol = " << opt.rel_tol << endl;
+    cout << "#regions = " << opt.regions << endl;
+    cout << "#expected = " << expected << endl;
+    cout << "#m, abs err, log2(err), calls, relerr, ifail" << endl;
+    for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
+        int maxpts = 1 << m;
+        if (maxpts < points) {
+            cout << "#2^" << dec << m << " is less than rule points" << endl;
+            continue;
+        }
+        int calls;
+        double relerr;
+        double finest;
+        int ifail = adapt_parallel(s, a, b, 0, maxpts, functn, opt.rel_tol,
+                                   opt.threads, opt.regions,
+                                   &calls, &relerr, &finest);
+        if (opt.verbose) {
+            cout << "calculated = " << finest << endl;
+        }
+        double error = abs(expected - finest);
+        cout << dec << m << "," << error << "," << log2(error) << ","
+             << calls << "," << relerr << "," << ifail << endl;
+    }
+    return 0;
+}
+
+namespace {
+    void cmd_message(const string& pgm)
+    {
+        cout << pgm << " -s s_dim -m start_m -M end_m -S seed -g genz_no"
+             << " [-o] [-D difficulty] [-e rel_tol] [-j threads]"
+             << " [-k regions] [-v]" << endl;
+        cout << "\t--end-m, -M\t\tat most 2^m function evaluations for m"
+             << " = start_m, ..., end_m" << endl;
+        cout << "\t--rel-tol, -e\t\trequested relative accuracy,"
+             << " default 0, all 2^m" << endl;
+        cout << "\t--threads, -j\t\tthreads dividing subregions" << endl;
+        cout << "\t--regions, -k\t\tsubregions divided at once,"
+             << " default 16," << endl
+             << "\t\t\t\t1 for the same order as adapt()" << endl;
+    }
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
+    {
+        int c;
+        bool error = false;
+        string pgm = argv[0];
+        static struct option longopts[] = {
+            {"s-dim", required_argument, NULL, 's'},
+            {"start-m", required_argument, NULL, 'm'},
+            {"end-m", required_argument, NULL, 'M'},
+            {"seed", required_argument, NULL, 'S'},
+            {"genz-no", required_argument, NULL, 'g'},
+            {"orignal", optional_argument, NULL, 'o'},
+            {"difficulty", required_argument, NULL, 'D'},
+            {"rel-tol", required_argument, NULL, 'e'},
+            {"threads", required_argument, NULL, 'j'},
+            {"regions", required_argument, NULL, 'k'},
+            {"verbose", no_argument, NULL, 'v'},
+            {NULL, 0, NULL, 0}};
+        opt.s_dim = 0;
+        opt.start_m = 0;
+        opt.end_m = 0;
+        opt.seed = 1;
+        opt.genz_no = 0;
+        opt.original = 0;
+        opt.difficulty = -1;
+        opt.rel_tol = 0;
+        opt.threads = 1;
+        opt.regions = 16;
+        opt.verbose = false;
+        errno = 0;
+        for (;;) {
+            c = getopt_long(argc, argv, "s:m:M:S:g:o::D:e:j:k:v", longopts,
+                            NULL);
+            if (error) {
+                break;
+            }
+            if (c == -1) {
+                break;
+            }
+            switch (c) {
+            case 's':
+                opt.s_dim = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "s_dim should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'm':
+                opt.start_m = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "start_m should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'M':
+                opt.end_m = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "end_m should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'S':
+                opt.seed = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "seed should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'g':
+                opt.genz_no = strtol(optarg, NULL, 10);
+                if (errno) {
+                    cout << "genz_no should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'o':
+                if (optarg == NULL) {
+                    opt.original = 1;
+                } else if (optarg[0] == 'x') {
+                    opt.original = -1;
+                } else {
+                    opt.original = strtol(optarg, NULL, 10);
+                    if (errno) {
+                        cout << "original shoud be one of {x(-1), 0, 1}."
+                             << endl;
+                        error = true;
+                    }
+                }
+                break;
+            case 'D':
+                opt.difficulty = strtod(optarg, NULL);
+                if (errno) {
+                    cout << "difficulty should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'e':
+                opt.rel_tol = strtod(optarg, NULL);
+                if (errno) {
+                    cout << "rel_tol should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'k':
+                opt.regions = strtol(optarg, NULL, 10);
+                if (errno || opt.regions < 1) {
+                    cout << "regions should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'v':
+                opt.verbose = true;
+                break;
+            case '?':
+            default:
+                error = true;
+                break;
+            }
+        }
+        if (opt.genz_no < 1 || opt.genz_no > 6) {
+            cout << "genz_no shoule be 1 <= genz_no <= 6" << endl;
+            error = true;
+        }
+        if (opt.s_dim < 2) {
+            cout << "s_dim should be at least 2" << endl;
+            error = true;
+        }
+        if (opt.end_m > 30) {
+            cout << "end_m should be at most 30" << endl;
+            error = true;
+        }
+        if (error) {
+            cmd_message(pgm);
+            return false;
+        }
+        if (opt.end_m < opt.start_m) {
+            opt.end_m = opt.start_m;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,437 @@
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include "adapt_parallel.h"
+#include "testpack.h"
+#include "thread_pool.hpp"
+#include "workspace.hpp"
+
+using namespace std;
+using namespace MCQMCIntegration;
+
+namespace {
+    /**
+     * constants of the basic rule, see adapt().
+     */
+    struct rule_t {
+        int ndim;
+        int points;
+        double lambda2;
+        double lambda4;
+        double lambda5;
+        double ratio;
+        double weit1;
+        double weit2;
+        double weit3;
+        double weit4;
+        double weit5;
+        double weitp1;
+        double weitp2;
+        double weitp3;
+        double weitp4;
+    };
+
+    struct region_t {
+        vector<double> center;
+        vector<double> width;
+        double value;
+        double error;
+        /** axis to divide, 1-based */
+        int axis;
+    };
+
+    void init_rule(rule_t& rule, int ndim);
+    void apply_rule(const rule_t& rule, const adapt_block_function& functn,
+                    int divaxo, region_t& region);
+    void divide(const region_t& parent, region_t& lower, region_t& upper);
+    void sift_down(vector<region_t>& heap, size_t pos, region_t& region);
+    void sift_up(vector<region_t>& heap, region_t& region);
+}
+
+int adapt_rule_points(int ndim)
+{
+    if (ndim <= 15) {
+        return i4_power(2, ndim) + 2 * ndim * ndim + 2 * ndim + 1;
+    } else {
+        return 1 + (ndim * (12 + (ndim - 1) * (6 + (ndim - 2) * 4))) / 3;
+    }
+}
+
+int adapt_parallel(int ndim, const double a[], const double b[],
+                   int minpts, int maxpts, const adapt_block_function& functn,
+                   double rel_tol, int threads, int regions,
+                   int *calls, double *relerr, double *finest)
+{
+    *calls = 0;
+    *relerr = 1.0;
+    *finest = 0.0;
+    if (ndim < 2 || maxpts < minpts || minpts < 0) {
+        return 3;
+    }
+    rule_t rule;
+    init_rule(rule, ndim);
+    if (maxpts < rule.points) {
+        return 3;
+    }
+    if (regions < 1) {
+        regions = 1;
+    }
+    unique_ptr<ThreadPool> pool;
+    if (threads > 1) {
+        pool.reset(new ThreadPool(threads));
+    }
+    vector<region_t> heap(1);
+    region_t& whole = heap[0];
+    whole.center.resize(ndim);
+    whole.width.resize(ndim);
+    for (int j = 0; j < ndim; j++) {
+        whole.width[j] = (b[j] - a[j]) / 2.0;
+        whole.center[j] = a[j] + whole.width[j];
+    }
+    apply_rule(rule, functn, 0, whole);
+    // running sums updated in the same order as adapt()
+    double value = whole.value;
+    double error = whole.error;
+    int funcls = rule.points;
+    int ifail;
+    vector<region_t> parent;
+    vector<region_t> child;
+    for (;;) {
+        if (error <= 0.0) {
+            error = 0.0;
+        }
+        *relerr = 1.0;
+        if (fabs(value) != 0.0) {
+            *relerr = error / fabs(value);
+        }
+        if (1.0 < *relerr) {
+            *relerr = 1.0;
+        }
+        ifail = 3;
+        int room = (maxpts - funcls) / (2 * rule.points);
+        if (room < 1) {
+            ifail = 1;
+        }
+        if (*relerr < rel_tol && minpts <= funcls) {
+            ifail = 0;
+        }
+        if (ifail < 3) {
+            break;
+        }
+        int k = min(min(regions, room), static_cast<int>(heap.size()));
+        parent.resize(k);
+        child.resize(2 * k);
+        for (int i = 0; i < k; i++) {
+            parent[i] = heap[0];
+            if (k > 1) {
+                region_t last = heap.back();
+                heap.pop_back();
+                if (!heap.empty()) {
+                    sift_down(heap, 0, last);
+                }
+            }
+            error = error - parent[i].error;
+            value = value - parent[i].value;
+            divide(parent[i], child[2 * i], child[2 * i + 1]);
+        }
+        if (pool) {
+            for (int i = 0; i < 2 * k; i++) {
+                region_t *r = &child[i];
+                int divaxo = parent[i / 2].axis;
+                pool->submit([&rule, &functn, r, divaxo]() {
+                        apply_rule(rule, functn, divaxo, *r);
+                    });
+            }
+            pool->wait();
+        } else {
+            for (int i = 0; i < 2 * k; i++) {
+                apply_rule(rule, functn, parent[i / 2].axis, child[i]);
+            }
+        }
+        for (int i = 0; i < 2 * k; i++) {
+            value = value + child[i].value;
+            error = error + child[i].error;
+            funcls = funcls + rule.points;
+            if (k == 1 && i == 0) {
+                // the lower half takes the place of the parent as adapt()
+                sift_down(heap, 0, child[i]);
+            } else {
+                sift_up(heap, child[i]);
+            }
+        }
+    }
+    *calls = funcls;
+    *finest = value;
+    return ifail;
+}
+
+namespace {
+    void init_rule(rule_t& rule, int ndim)
+    {
+        rule.ndim = ndim;
+        rule.points = adapt_rule_points(ndim);
+        double lambda5 = 9.0 / 19.0;
+        double lambda4;
+        double lambda2;
+        double ratio;
+        if (ndim <= 15) {
+            lambda4 = 9.0 / 10.0;
+            lambda2 = 9.0 / 70.0;
+            rule.weit5 = 1.0 / pow(3.0 * lambda5, 3) / pow(2.0, ndim);
+        } else {
+            ratio = static_cast<double>(ndim - 2) / 9.0;
+            lambda4 = (1.0 / 5.0 - ratio) / (1.0 / 3.0 - ratio / lambda5);
+            ratio = (1.0 - lambda4 / lambda5)
+                * static_cast<double>(ndim - 1) * ratio / 6.0;
+            lambda2 = (1.0 / 7.0 - lambda4 / 5.0 - ratio)
+                / (1.0 / 5.0 - lambda4 / 3.0 - ratio / lambda5);
+            rule.weit5 = 1.0 / pow(6.0 * lambda5, 3);
+        }
+        rule.weit4 = (1.0 / 15.0 - lambda5 / 9.0)
+            / (4.0 * (lambda4 - lambda5) * lambda4 * lambda4);
+        rule.weit3 = (1.0 / 7.0 - (lambda5 + lambda2) / 5.0
+                      + lambda5 * lambda2 / 3.0) / (2.0 * lambda4
+                      * (lambda4 - lambda5) * (lambda4 - lambda2))
+            - 2.0 * static_cast<double>(ndim - 1) * rule.weit4;
+        rule.weit2 = (1.0 / 7.0 - (lambda5 + lambda4) / 5.0
+                      + lambda5 * lambda4 / 3.0) / (2.0 * lambda2
+                      * (lambda2 - lambda5) * (lambda2 - lambda4));
+        if (ndim <= 15) {
+            rule.weit1 = 1.0 - 2.0 * static_cast<double>(ndim)
+                * (rule.weit2 + rule.weit3
+                   + static_cast<double>(ndim - 1) * rule.weit4)
+                - pow(2.0, ndim) * rule.weit5;
+        } else {
+            rule.weit1 = 1.0 - 2.0 * static_cast<double>(ndim)
+                * (rule.weit2 + rule.weit3
+                   + static_cast<double>(ndim - 1)
+                   * (rule.weit4 + 2.0 * static_cast<double>(ndim - 2)
+                      * rule.weit5 / 3.0));
+        }
+        rule.weitp4 = 1.0 / pow(6.0 * lambda4, 2);
+        rule.weitp3 = (1.0 / 5.0 - lambda2 / 3.0)
+            / (2.0 * lambda4 * (lambda4 - lambda2))
+            - 2.0 * static_cast<double>(ndim - 1) * rule.weitp4;
+        rule.weitp2 = (1.0 / 5.0 - lambda4 / 3.0)
+            / (2.0 * lambda2 * (lambda2 - lambda4));
+        rule.weitp1 = 1.0 - 2.0 * static_cast<double>(ndim)
+            * (rule.weitp2 + rule.weitp3
+               + static_cast<double>(ndim - 1) * rule.weitp4);
+        rule.ratio = lambda2 / lambda4;
+        rule.lambda5 = sqrt(lambda5);
+        rule.lambda4 = sqrt(lambda4);
+        rule.lambda2 = sqrt(lambda2);
+    }
+
+    /**
+     * put region to the hole at pos and move it down, the comparisons
+     * are the same as the partially ordered list of adapt().
+     */
+    void sift_down(vector<region_t>& heap, size_t pos, region_t& region)
+    {
+        for (;;) {
+            size_t c = 2 * pos + 1;
+            if (c >= heap.size()) {
+                break;
+            }
+            if (c + 1 < heap.size() && heap[c].error < heap[c + 1].error) {
+                c = c + 1;
+            }
+            if (heap[c].error <= region.error) {
+                break;
+            }
+            swap(heap[pos], heap[c]);
+            pos = c;
+        }
+        swap(heap[pos], region);
+    }
+
+    /**
+     * add region to the bottom and move it up as adapt().
+     */
+    void sift_up(vector<region_t>& heap, region_t& region)
+    {
+        size_t pos = heap.size();
+        heap.push_back(region_t());
+        while (pos > 0) {
+            size_t p = (pos - 1) / 2;
+            if (region.error <= heap[p].error) {
+                break;
+            }
+            swap(heap[pos], heap[p]);
+            pos = p;
+        }
+        swap(heap[pos], region);
+    }
+
+    /**
+     * halves of parent divided at parent.axis, in the order of adapt().
+     */
+    void divide(const region_t& parent, region_t& lower, region_t& upper)
+    {
+        int ax = parent.axis - 1;
+        lower.center = parent.center;
+        lower.width = parent.width;
+        lower.width[ax] = lower.width[ax] / 2.0;
+        lower.center[ax] = lower.center[ax] - lower.width[ax];
+        upper.center = lower.center;
+        upper.width = lower.width;
+        upper.center[ax] = upper.center[ax] + 2.0 * upper.width[ax];
+    }
+
+    /**
+     * the basic rule of adapt() for region. The points are made in the
+     * order of adapt() and evaluated at once, then summed in the same
+     * order as adapt(), so that the value and the error are the same.
+     * @param divaxo axis divided last, 1-based, 0 for the whole region.
+     */
+    void apply_rule(const rule_t& rule, const adapt_block_function& functn,
+                    int divaxo, region_t& region)
+    {
+        static thread_local Workspace work;
+        work.reset();
+        const int ndim = rule.ndim;
+        const double *center = &region.center[0];
+        const double *width = &region.width[0];
+        double *point = work.alloc(static_cast<size_t>(rule.points) * ndim);
+        double *f = work.alloc(rule.points);
+        double *z = work.alloc(ndim);
+        double *widthl = work.alloc(ndim);
+        const size_t points = rule.points;
+        // columns of the points, made column by column in the order of
+        // the points of adapt()
+        const int first4 = 1 + 4 * ndim;
+        const int first5 = first4 + 2 * ndim * (ndim - 1);
+        for (int j = 0; j < ndim; j++) {
+            fill(point + j * points, point + j * points + first5, center[j]);
+        }
+        for (int j = 0; j < ndim; j++) {
+            double *col = point + j * points + 1 + 4 * j;
+            col[0] = center[j] - rule.lambda2 * width[j];
+            col[1] = center[j] + rule.lambda2 * width[j];
+            widthl[j] = rule.lambda4 * width[j];
+            col[2] = center[j] - widthl[j];
+            col[3] = center[j] + widthl[j];
+        }
+        // symmetric sum of (lambda4, lambda4, 0, ..., 0), signs of
+        // coordinates p < q are (-, -), (-, +), (+, -), (+, +)
+        int n = first4;
+        for (int p = 0; p < ndim; p++) {
+            double *colp = point + p * points;
+            double lower = center[p] - widthl[p];
+            double upper = center[p] + widthl[p];
+            for (int q = p + 1; q < ndim; q++) {
+                double *colq = point + q * points;
+                colp[n] = lower;
+                colq[n] = center[q] - widthl[q];
+                colp[n + 1] = lower;
+                colq[n + 1] = center[q] + widthl[q];
+                colp[n + 2] = upper;
+                colq[n + 2] = center[q] - widthl[q];
+                colp[n + 3] = upper;
+                colq[n + 3] = center[q] + widthl[q];
+                n += 4;
+            }
+        }
+        if (ndim <= 15) {
+            // all signs of (lambda5, ..., lambda5), the sign of j-th
+            // coordinate of t-th point is bit ndim - 1 - j of t
+            int count = 1 << ndim;
+            for (int j = 0; j < ndim; j++) {
+                double *col = point + j * points + first5;
+                double lower = center[j] + -rule.lambda5 * width[j];
+                double upper = center[j] + rule.lambda5 * width[j];
+                int run = 1 << (ndim - 1 - j);
+                for (int t = 0; t < count; t += 2 * run) {
+                    fill(col + t, col + t + run, lower);
+                    fill(col + t + run, col + t + 2 * run, upper);
+                }
+            }
+            n += count;
+        } else {
+            for (int j = 0; j < ndim; j++) {
+                fill(point + j * points + first5, point + (j + 1) * points,
+                     center[j]);
+            }
+            // symmetric sum of (lambda5, lambda5, lambda5, 0, ..., 0)
+            for (int j = 0; j < ndim; j++) {
+                z[j] = center[j];
+                widthl[j] = rule.lambda5 * width[j];
+            }
+            auto put = [&]() {
+                for (int j = 0; j < ndim; j++) {
+                    point[j * points + n] = z[j];
+                }
+                n++;
+            };
+            for (int i = 3; i <= ndim; i++) {
+                for (int j = i; j <= ndim; j++) {
+                    for (int k = j; k <= ndim; k++) {
+                        for (int l = 1; l <= 2; l++) {
+                            widthl[i - 3] = -widthl[i - 3];
+                            z[i - 3] = center[i - 3] + widthl[i - 3];
+                            for (int m = 1; m <= 2; m++) {
+                                widthl[j - 2] = -widthl[j - 2];
+                                z[j - 2] = center[j - 2] + widthl[j - 2];
+                                for (int q = 1; q <= 2; q++) {
+                                    widthl[k - 1] = -widthl[k - 1];
+                                    z[k - 1] = center[k - 1]
+                                        + widthl[k - 1];
+                                    put();
+                                }
+                            }
+                        }
+                        z[k - 1] = center[k - 1];
+                    }
+                    z[j - 2] = center[j - 2];
+                }
+                z[i - 3] = center[i - 3];
+            }
+        }
+        functn(n, point, f);
+
+        double sum1 = f[0];
+        double difmax = -1.0;
+        double sum2 = 0.0;
+        double sum3 = 0.0;
+        int divaxn = (divaxo % ndim) + 1;
+        for (int j = 0; j < ndim; j++) {
+            const double *fj = &f[1 + 4 * j];
+            double df1 = fj[0] + fj[1] - 2.0 * sum1;
+            double df2 = fj[2] + fj[3] - 2.0 * sum1;
+            double dif = fabs(df1 - rule.ratio * df2);
+            sum2 = sum2 + fj[0] + fj[1];
+            sum3 = sum3 + fj[2] + fj[3];
+            if (difmax < dif) {
+                difmax = dif;
+                divaxn = j + 1;
+            }
+        }
+        if (sum1 == sum1 + difmax / 8.0) {
+            divaxn = (divaxo % ndim) + 1;
+        }
+        double sum4 = 0.0;
+        for (int i = first4; i < first5; i++) {
+            sum4 = sum4 + f[i];
+        }
+        double sum5 = 0.0;
+        for (int i = first5; i < n; i++) {
+            sum5 = sum5 + f[i];
+        }
+        double rgnvol = pow(2.0, ndim)
+            * r8vec_product(ndim, &region.width[0]);
+        double rgncmp = rgnvol * (rule.weitp1 * sum1
+                                  + rule.weitp2 * sum2
+                                  + rule.weitp3 * sum3
+                                  + rule.weitp4 * sum4);
+        double rgnval = rgnvol * (rule.weit1 * sum1
+                                  + rule.weit2 * sum2
+                                  + rule.weit3 * sum3
+                                  + rule.weit4 * sum4
+                                  + rule.weit5 * sum5);
+        region.value = rgnval;
+        region.error = fabs(rgnval - rgncmp);
+        region.axis = divaxn;
+    }
+}
@@ -0,0 +1,60 @@
+#pragma once
+#ifndef ADAPT_PARALLEL_H
+#define ADAPT_PARALLEL_H
+/**
+ * @file adapt_parallel.h
+ *
+ * @brief adaptive cubature of adapt() in testpack.cpp with a heap of
+ * subregions divided by threads.
+ */
+
+#include <functional>
+
+/**
+ * functn(n, z, value) sets value[i] to the integrand at the i-th point
+ * for i < n. The points are dimension-major, z[j * n + i] is the j-th
+ * coordinate of the i-th point, as GenzBinding::evaluate().
+ */
+typedef std::function<void(int n, const double z[], double value[])>
+adapt_block_function;
+
+/**
+ * number of points of the basic rule of adapt() for ndim, RULCLS.
+ */
+int adapt_rule_points(int ndim);
+
+/**
+ * Adaptive cubature by the basic rule and the division of adapt().
+ *
+ * Subregions are kept in a heap ordered by their error estimates.
+ * In each round, as many subregions as regions with the largest errors
+ * are divided into halves, the rule is applied to the halves by threads,
+ * and all rule points of a half are given to functn at once. The
+ * halves are added to the estimates in a fixed order, so the result
+ * depends on regions but not on threads. With regions = 1 and the same
+ * function values, the result is the same as adapt().
+ * Unlike adapt(), no work array is needed, so IFAIL 2 is not returned,
+ * and a previous calculation can't be continued.
+ *
+ * @param ndim number of variables, 2 <= ndim
+ * @param a lower limits of integration
+ * @param b upper limits of integration
+ * @param minpts minimum number of function evaluations
+ * @param maxpts maximum number of function evaluations, at least
+ * adapt_rule_points(ndim)
+ * @param functn integrand
+ * @param rel_tol requested relative accuracy
+ * @param threads number of threads
+ * @param regions number of subregions divided in a round
+ * @param calls output, number of function evaluations
+ * @param relerr output, estimated relative accuracy
+ * @param finest output, estimated value of the integral
+ * @return IFAIL of adapt(), 0 if relerr < rel_tol, 1 if maxpts is too
+ * small for rel_tol, 3 if the arguments are wrong.
+ */
+int adapt_parallel(int ndim, const double a[], const double b[],
+                   int minpts, int maxpts, const adapt_block_function& functn,
+                   double rel_tol, int threads, int regions,
+                   int *calls, double *relerr, double *finest);
+
+#endif // ADAPT_PARALLEL_H
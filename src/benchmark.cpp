@@ -0,0 +1,445 @@
+#include <cerrno>
+#include <getopt.h>
+#include <cstdlib>
+#include <string>
+#include <MCQMCIntegration/DigitalNet.h>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <exception>
+#include "testpack.h"
+#include "Genz.hpp"
+#include "genz_simd.h"
+#include "saipack.hpp"
+#include "kahan.hpp"
+#include "mt19937_64.hpp"
+#include "RandomNet.hpp"
+#include "GrayCodeNet.hpp"
+
+using namespace std;
+using namespace MCQMCIntegration;
+using namespace GenzNS;
+
+/*
+ * Cost of integrands, point generators and summation, printed as JSON.
+ * Every case is repeated until some time has passed, and the time per
+ * point (per number for random number generators and per term for
+ * summation) is reported. Results of the cases are added to a sink, so
+ * that the compiler can't remove them.
+ */
+namespace {
+    struct cmd_opt_t {
+        int max_s;
+        int m;
+        int dn_id;
+        double seconds;
+    };
+
+    // number of points evaluated by one call in a case
+    const int points_per_call = 256;
+
+    volatile double sink;
+
+    bool first_result = true;
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
+    void cmd_message(const string& pgm);
+    void print_result(const string& group, const string& name, int index,
+                      int s, double ns);
+    void bench_genz(const cmd_opt_t& opt, int s);
+    void bench_saipack(const cmd_opt_t& opt, int s);
+    void bench_nets(const cmd_opt_t& opt, int s);
+    void bench_random(const cmd_opt_t& opt);
+    void bench_kahan(const cmd_opt_t& opt);
+
+    /**
+     * nano seconds per point of f.
+     * @param f function which processes points points at a call
+     * @param points number of points processed by f at a call
+     * @param seconds minimum time of measurement
+     */
+    template<typename F>
+    double measure(F f, uint64_t points, double seconds)
+    {
+        typedef chrono::steady_clock clock_type;
+        f(); // warm up
+        uint64_t calls = 0;
+        clock_type::time_point start = clock_type::now();
+        double elapsed;
+        do {
+            for (int i = 0; i < 16; i++) {
+                f();
+            }
+            calls += 16;
+            elapsed = chrono::duration<double>(clock_type::now()
+                                               - start).count();
+        } while (elapsed < seconds);
+        return elapsed * 1e9 / (static_cast<double>(calls) * points);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    cmd_opt_t opt;
+    if (!parse_opt(opt, argc, argv)) {
+        return -1;
+    }
+    cout << "{" << endl;
+    cout << "  \"isa\": \"" << GenzSIMD::isa() << "\"," << endl;
+    cout << "  \"seconds\": " << opt.seconds << "," << endl;
+    cout << "  \"digitalnet\": \"" << getDigitalNetName(opt.dn_id) << "\","
+         << endl;
+    cout << "  \"m\": " << opt.m << "," << endl;
+    cout << "  \"results\": [";
+    for (int s = 1; s <= opt.max_s; s *= 2) {
+        bench_genz(opt, s);
+        bench_saipack(opt, s);
+        bench_nets(opt, s);
+    }
+    bench_random(opt);
+    bench_kahan(opt);
+    cout << endl << "  ]" << endl;
+    cout << "}" << endl;
+    return 0;
+}
+
+namespace {
+    void print_result(const string& group, const string& name, int index,
+                      int s, double ns)
+    {
+        if (!first_result) {
+            cout << ",";
+        }
+        first_result = false;
+        cout << endl << "    {\"group\": \"" << group << "\""
+             << ", \"name\": \"" << name << "\""
+             << ", \"index\": " << dec << index
+             << ", \"s\": " << s
+             << setprecision(6)
+             << ", \"ns_per_point\": " << ns
+             << ", \"points_per_second\": " << (1e9 / ns) << "}";
+    }
+
+    // points_per_call random points, point-major and dimension-major
+    void make_points(int s, vector<double>& aos, vector<double>& soa)
+    {
+        std::mt19937_64 mt(1);
+        uniform_real_distribution<double> unif01(0.0, 1.0);
+        aos.resize(points_per_call * s);
+        soa.resize(points_per_call * s);
+        for (int i = 0; i < points_per_call; i++) {
+            for (int j = 0; j < s; j++) {
+                double x = unif01(mt);
+                aos[i * s + j] = x;
+                soa[j * points_per_call + i] = x;
+            }
+        }
+    }
+
+    void bench_genz(const cmd_opt_t& opt, int s)
+    {
+        vector<double> aos;
+        vector<double> soa;
+        make_points(s, aos, soa);
+        std::mt19937_64 mt(1);
+        uniform_real_distribution<double> unif01(0.0, 1.0);
+        vector<double> alpha(s);
+        vector<double> beta(s);
+        for (int j = 0; j < s; j++) {
+            alpha[j] = unif01(mt);
+            beta[j] = unif01(mt);
+        }
+        shared_ptr<GenzFunction> genz[] = {
+            shared_ptr<GenzFunction>(new Oscillatory()),
+            shared_ptr<GenzFunction>(new ProductPeak()),
+            shared_ptr<GenzFunction>(new CornerPeak()),
+            shared_ptr<GenzFunction>(new Gaussian()),
+            shared_ptr<GenzFunction>(new C0Function()),
+            shared_ptr<GenzFunction>(new Discontinuous())
+        };
+        const double *z = &aos[0];
+        const double *a = &alpha[0];
+        const double *b = &beta[0];
+        for (int indx = 1; indx <= 6; indx++) {
+            double ns = measure([=]() {
+                    double sum = 0;
+                    for (int i = 0; i < points_per_call; i++) {
+                        sum += genz_function(indx, s, &z[i * s], a, b);
+                    }
+                    sink = sink + sum;
+                }, points_per_call, opt.seconds);
+            print_result("genz_function", genz[indx - 1]->name(), indx, s,
+                         ns);
+        }
+        vector<double> values(points_per_call);
+        double *v = &values[0];
+        for (int k = 0; k < 6; k++) {
+            GenzFunction& func = *genz[k];
+            // through base class, as one point at a time
+            double ns = measure([&func, z, a, b, s]() {
+                    double sum = 0;
+                    for (int i = 0; i < points_per_call; i++) {
+                        sum += func(s, &z[i * s], a, b);
+                    }
+                    sink = sink + sum;
+                }, points_per_call, opt.seconds);
+            print_result("GenzFunction::operator()", func.name(), k + 1, s,
+                         ns);
+            func.bind(s, a, b);
+            const double *x = &soa[0];
+            ns = measure([&func, x, v]() {
+                    func.evaluateBound(points_per_call, x, v);
+                    sink = sink + v[0];
+                }, points_per_call, opt.seconds);
+            print_result("GenzFunction::evaluateBound", func.name(), k + 1,
+                         s, ns);
+        }
+    }
+
+    template<typename F>
+    void bench_saipack_function(const cmd_opt_t& opt, int s, int index,
+                                const vector<double>& points)
+    {
+        F func;
+        std::mt19937_64 mt(1);
+        vector<double> a(s);
+        vector<double> b(s);
+        func.makeParameter(1, s, mt, &a[0], &b[0], false);
+        func.setParam(s, &a[0], &b[0]);
+        const double *z = &points[0];
+        Saipack& base = func;
+        // through base class, as one point at a time
+        double ns = measure([&base, z, s]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    sum += base(&z[i * s]);
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("Saipack::operator()", func.getName(), index, s, ns);
+        vector<double> values(points_per_call);
+        double *v = &values[0];
+        ns = measure([&func, z, v]() {
+                func.evaluate(points_per_call, z, v);
+                sink = sink + v[0];
+            }, points_per_call, opt.seconds);
+        print_result("Saipack::evaluate", func.getName(), index, s, ns);
+    }
+
+    void bench_saipack(const cmd_opt_t& opt, int s)
+    {
+        vector<double> aos;
+        vector<double> soa;
+        make_points(s, aos, soa);
+        bench_saipack_function<AddSai>(opt, s, 0, aos);
+        bench_saipack_function<MulSai>(opt, s, 1, aos);
+        bench_saipack_function<SinSai>(opt, s, 2, aos);
+        bench_saipack_function<PolSai>(opt, s, 3, aos);
+    }
+
+    void bench_nets(const cmd_opt_t& opt, int s)
+    {
+        string name = getDigitalNetName(opt.dn_id);
+        DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
+        unique_ptr<DigitalNet<uint64_t> > dn;
+        try {
+            dn.reset(new DigitalNet<uint64_t>(dnid, s, opt.m));
+        } catch (const exception&) {
+            // s is not supported by the digital net
+            return;
+        }
+        dn->pointInitialize();
+        DigitalNet<uint64_t>& net = *dn;
+        double ns = measure([&net]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    net.nextPoint();
+                    sum += net.getPoint()[0];
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("DigitalNet::nextPoint", name, opt.dn_id, s, ns);
+        GrayCodeNet gc(net);
+        ns = measure([&gc]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    gc.nextPoint();
+                    sum += gc.getPoint()[0];
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("GrayCodeNet::nextPoint", name, opt.dn_id, s, ns);
+        vector<uint64_t> base(points_per_call * s);
+        uint64_t *p = &base[0];
+        ns = measure([&gc, p]() {
+                gc.fillBase(p, points_per_call);
+                sink = sink + static_cast<double>(p[0]);
+            }, points_per_call, opt.seconds);
+        print_result("GrayCodeNet::fillBase", name, opt.dn_id, s, ns);
+        RandomNet rn(s, 1);
+        rn.pointInitialize();
+        ns = measure([&rn]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    rn.nextPoint();
+                    sum += rn.getPoint()[0];
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("RandomNet::nextPoint", "Random", 100, s, ns);
+    }
+
+    void bench_random(const cmd_opt_t& opt)
+    {
+        ::mt19937_64 mt(1);
+        double ns = measure([&mt]() {
+                uint64_t x = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    x ^= mt.getUint64();
+                }
+                sink = sink + static_cast<double>(x);
+            }, points_per_call, opt.seconds);
+        print_result("mt19937_64::getUint64", "mt19937_64", 0, 1, ns);
+        ns = measure([&mt]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    sum += mt.getDouble01();
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("mt19937_64::getDouble01", "mt19937_64", 0, 1, ns);
+        vector<uint64_t> ubuf(points_per_call);
+        uint64_t *up = &ubuf[0];
+        ns = measure([&mt, up]() {
+                mt.fill(up, points_per_call);
+                sink = sink + static_cast<double>(up[0]);
+            }, points_per_call, opt.seconds);
+        print_result("mt19937_64::fill", "mt19937_64", 0, 1, ns);
+        vector<double> dbuf(points_per_call);
+        double *dp = &dbuf[0];
+        ns = measure([&mt, dp]() {
+                mt.fillDouble01(dp, points_per_call);
+                sink = sink + dp[0];
+            }, points_per_call, opt.seconds);
+        print_result("mt19937_64::fillDouble01", "mt19937_64", 0, 1, ns);
+        std::mt19937_64 smt(1);
+        uniform_real_distribution<double> unif01(0.0, 1.0);
+        ns = measure([&smt, &unif01]() {
+                double sum = 0;
+                for (int i = 0; i < points_per_call; i++) {
+                    sum += unif01(smt);
+                }
+                sink = sink + sum;
+            }, points_per_call, opt.seconds);
+        print_result("std::uniform_real_distribution", "std::mt19937_64", 0,
+                     1, ns);
+    }
+
+    void bench_kahan(const cmd_opt_t& opt)
+    {
+        const int terms = 4096;
+        vector<double> x(terms);
+        std::mt19937_64 mt(1);
+        uniform_real_distribution<double> unif01(0.0, 1.0);
+        for (int i = 0; i < terms; i++) {
+            x[i] = unif01(mt);
+        }
+        const double *p = &x[0];
+        double ns = measure([p]() {
+                Kahan sum;
+                for (int i = 0; i < terms; i++) {
+                    sum.add(p[i]);
+                }
+                sink = sink + sum.get();
+            }, terms, opt.seconds);
+        print_result("Kahan::add", "Kahan", 0, 1, ns);
+        ns = measure([p]() {
+                KahanLanes sum;
+                sum.add(p, terms);
+                sink = sink + sum.get();
+            }, terms, opt.seconds);
+        print_result("KahanLanes::add", "KahanLanes", 0, 1, ns);
+    }
+
+    void cmd_message(const string& pgm)
+    {
+        cout << pgm << " [-s max_s] [-m m] [-d digitalnet_id] [-t seconds]"
+             << endl;
+        cout << "\t--max-s, -s\t\tdimensions are 1, 2, 4, ..., max_s,"
+             << " default 256" << endl;
+        cout << "\t--m, -m\t\t\tdigital nets have 2^m points, default 20"
+             << endl;
+        cout << "\t--digitalnet-id, -d\tdigital net, default 1" << endl;
+        cout << "\t--seconds, -t\t\tminimum time of each case,"
+             << " default 0.1" << endl;
+    }
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
+    {
+        int c;
+        bool error = false;
+        string pgm = argv[0];
+        static struct option longopts[] = {
+            {"max-s", required_argument, NULL, 's'},
+            {"m", required_argument, NULL, 'm'},
+            {"digitalnet-id", required_argument, NULL, 'd'},
+            {"seconds", required_argument, NULL, 't'},
+            {NULL, 0, NULL, 0}};
+        opt.max_s = 256;
+        opt.m = 20;
+        opt.dn_id = 1;
+        opt.seconds = 0.1;
+        errno = 0;
+        for (;;) {
+            c = getopt_long(argc, argv, "s:m:d:t:", longopts, NULL);
+            if (error) {
+                break;
+            }
+            if (c == -1) {
+                break;
+            }
+            switch (c) {
+            case 's':
+                opt.max_s = strtol(optarg, NULL, 10);
+                if (errno || opt.max_s < 1) {
+                    cout << "max_s should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'm':
+                opt.m = strtol(optarg, NULL, 10);
+                if (errno || opt.m < 1) {
+                    cout << "m should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'd':
+                opt.dn_id = strtol(optarg, NULL, 10);
+                if (errno) {
+                    cout << "digitalnet_id should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 't':
+                opt.seconds = strtod(optarg, NULL);
+                if (errno || !(opt.seconds > 0)) {
+                    cout << "seconds should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case '?':
+            default:
+                error = true;
+                break;
+            }
+        }
+        if (error || optind != argc) {
+            cmd_message(pgm);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef BIT_PLANES_HPP
+#define BIT_PLANES_HPP
+
+#include <inttypes.h>
+#include <vector>
+#include "GrayCodeNet.hpp"
+
+namespace MCQMCIntegration {
+
+    /**
+     * transpose 64 x 64 bit matrix in place.
+     * Bit 63 - c of a[r] is moved to bit 63 - r of a[c], so that if
+     * a[p] is a coordinate of p-th point, a[k] becomes the bit plane of
+     * k-th bit after the binary point, whose bit 63 - p is the bit of
+     * p-th point.
+     */
+    inline void transpose64(uint64_t a[64])
+    {
+        uint64_t mask = UINT64_C(0x00000000FFFFFFFF);
+        for (int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+            for (int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+                uint64_t t = (a[k] ^ (a[k | j] >> j)) & mask;
+                a[k] ^= t;
+                a[k | j] ^= t << j;
+            }
+        }
+    }
+
+    inline int popcount64(uint64_t x)
+    {
+        return __builtin_popcountll(x);
+    }
+
+    /**
+     * the mask of the first n points of a transposed block.
+     */
+    inline uint64_t plane_mask(int n)
+    {
+        if (n >= 64) {
+            return ~UINT64_C(0);
+        }
+        if (n <= 0) {
+            return 0;
+        }
+        return ~UINT64_C(0) << (64 - n);
+    }
+
+    /**
+     * count the points by bit patterns of bits planes.
+     * The pattern of a point is made of its bits of plane[0], ...,
+     * plane[bits - 1], plane[0] is the most significant bit.
+     * Points are split by one plane after another, which takes
+     * 2^(bits + 1) operations for 64 points, so this is faster than
+     * counting point by point only for small bits.
+     * @param plane bit planes
+     * @param bits number of planes
+     * @param valid mask of the points to be counted
+     * @param sum sum[pattern] is incremented by the number of points
+     * @param work 2^bits words
+     */
+    inline void count_patterns(const uint64_t plane[], int bits,
+                               uint64_t valid, uint64_t sum[],
+                               uint64_t work[])
+    {
+        work[0] = valid;
+        int size = 1;
+        for (int b = 0; b < bits; b++) {
+            for (int i = size - 1; i >= 0; i--) {
+                uint64_t w = work[i];
+                work[2 * i + 1] = w & plane[b];
+                work[2 * i] = w & ~plane[b];
+            }
+            size *= 2;
+        }
+        for (int i = 0; i < size; i++) {
+            sum[i] += popcount64(work[i]);
+        }
+    }
+
+    /**
+     * Bit planes of blocks of 64 points of GrayCodeNet.
+     *
+     * In a block starting at a multiple of 64, the points are the first
+     * point of the block XOR the combinations of the first 6 rows of the
+     * generating matrices in the same order for every block. So the
+     * planes of the combinations are transposed once, and a plane of a
+     * block is the plane of the combinations inverted if the first point
+     * has 1 at the bit. The net should have m >= 6.
+     */
+    class GrayCodePlanes {
+    public:
+        /**
+         * @param net digital net, it is copied.
+         * @param depth number of planes from the binary point needed.
+         */
+        GrayCodePlanes(const GrayCodeNet& net, int depth) : cursor(net) {
+            s = net.getS();
+            this->depth = depth;
+            pattern.resize(static_cast<size_t>(s) * 64);
+            planes.resize(static_cast<size_t>(s) * 64);
+            std::vector<uint64_t> buf(static_cast<size_t>(s) * 64);
+            cursor.setIndex(0);
+            cursor.fillBase(&buf[0], 64);
+            for (int j = 0; j < s; j++) {
+                uint64_t *plane = &pattern[static_cast<size_t>(j) * 64];
+                for (int p = 0; p < 64; p++) {
+                    plane[p] = buf[static_cast<size_t>(p) * s + j] ^ buf[j];
+                }
+                transpose64(plane);
+            }
+        }
+        static bool usable(const GrayCodeNet& net) {
+            return net.getM() >= 6;
+        }
+        /**
+         * planes of 64 points from first, see transpose64(),
+         * planes[j * 64 + k] for k < depth is the plane of k-th bit of
+         * j-th coordinate.
+         * @param first index of the first point, a multiple of 64.
+         */
+        const uint64_t * getPlanes(uint64_t first) {
+            cursor.setIndex(first);
+            const uint64_t *point = cursor.getPointBase();
+            for (int j = 0; j < s; j++) {
+                const uint64_t *from = &pattern[static_cast<size_t>(j) * 64];
+                uint64_t *to = &planes[static_cast<size_t>(j) * 64];
+                for (int k = 0; k < depth; k++) {
+                    to[k] = from[k] ^ (0 - ((point[j] >> (63 - k)) & 1));
+                }
+            }
+            return &planes[0];
+        }
+    private:
+        GrayCodeNet cursor;
+        int s;
+        int depth;
+        std::vector<uint64_t> pattern;
+        std::vector<uint64_t> planes;
+    };
+}
+#endif // BIT_PLANES_HPP
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef BOUNDED_QUEUE_HPP
+#define BOUNDED_QUEUE_HPP
+
+#include <deque>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+
+namespace MCQMCIntegration {
+
+    /**
+     * Queue of at most capacity items shared by producer threads and
+     * consumer threads.
+     *
+     * push() blocks while the queue is full, so that producers run
+     * ahead of consumers by at most capacity items. After all
+     * producers called close(), pop() returns false when the queue
+     * becomes empty.
+     */
+    template<typename T>
+    class BoundedQueue {
+    public:
+        /**
+         * @param capacity maximum number of items, at least one.
+         * @param producers number of threads which call close().
+         */
+        BoundedQueue(size_t capacity, int producers) {
+            this->capacity = capacity < 1 ? 1 : capacity;
+            this->producers = producers;
+        }
+        void push(T item) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_full.wait(lock, [this]() {
+                        return items.size() < capacity;
+                    });
+                items.push_back(std::move(item));
+            }
+            not_empty.notify_one();
+        }
+        /**
+         * @param item the first item is moved to it.
+         * @return false if the queue is empty and closed.
+         */
+        bool pop(T& item) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                not_empty.wait(lock, [this]() {
+                        return !items.empty() || producers <= 0;
+                    });
+                if (items.empty()) {
+                    return false;
+                }
+                item = std::move(items.front());
+                items.pop_front();
+            }
+            not_full.notify_one();
+            return true;
+        }
+        /**
+         * a producer has no more items.
+         */
+        void close() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                producers--;
+            }
+            not_empty.notify_all();
+        }
+    private:
+        BoundedQueue(const BoundedQueue&);
+        BoundedQueue& operator=(const BoundedQueue&);
+        std::deque<T> items;
+        size_t capacity;
+        int producers;
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+    };
+}
+#endif // BOUNDED_QUEUE_HPP
@@ -8,12 +8,17 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <algorithm>
 #include "testpack.h"
 #include "make_parameters.h"
+#include "result_store.h"
+#include "workspace.hpp"
 
 #if defined(HAVE_MPI_H)
 #include <mpi.h>
-#include "change_output.h"
 #else
 #define MPI_Finalize()
 #endif
@@ -30,24 +35,39 @@ namespace {
         uint32_t seed;
         int genz_no;
         int original;
+        string dbfile;
     };
+    typedef map<uint32_t, string> result_map;
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
     void cmd_message(const string& pgm);
-    int calc_theoretical(uint32_t dim, uint32_t seed, uint32_t genz_no,
-                         int original);
+    ResultKey make_key(const cmd_opt_t& opt, uint32_t dim);
+    string stored_text(const cmd_opt_t& opt, uint32_t dim, double value);
+    void print_parameter(const cmd_opt_t& opt, uint32_t dim, ostream& out,
+                         double a[], double b[], double alpha[],
+                         double beta[]);
+    double calc_theoretical(const cmd_opt_t& opt, uint32_t dim,
+                            string& text);
+    void make_jobs(const cmd_opt_t& opt, ResultStore& store,
+                   vector<uint32_t>& jobs, result_map& results);
+    void run_local(const cmd_opt_t& opt, ResultStore& store,
+                   const vector<uint32_t>& jobs, result_map& results);
+#if defined(HAVE_MPI_H)
+    enum {TAG_JOB = 1, TAG_STOP, TAG_VALUE, TAG_TEXT};
+    void run_master(const cmd_opt_t& opt, ResultStore& store,
+                    int num_process, const vector<uint32_t>& jobs,
+                    result_map& results);
+    void run_worker(const cmd_opt_t& opt);
+#endif
 }
 
 int main(int argc, char *argv[]) {
+#if defined(HAVE_MPI_H)
     int rank;
     int num_process;
-#if defined(HAVE_MPI_H)
     // MPI_Status status;
     MPI_Init(&argc, &argv);
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &num_process);
-#else
-    rank = 0;
-    num_process = 1;
 #endif
     cmd_opt_t opt;
     if (!parse_opt(opt, argc, argv)) {
@@ -55,10 +75,37 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 #if defined(HAVE_MPI_H)
-    if (!change_output(argv[0], rank, opt.s_dim, opt.genz_no, opt.seed)) {
+    if (rank != 0) {
+        run_worker(opt);
+        MPI_Finalize();
+        return 0;
+    }
+#endif
+    ResultStore store;
+    if (!opt.dbfile.empty() && !store.open(opt.dbfile)) {
+        cout << "can't open database " << opt.dbfile << ": "
+             << store.errorMessage() << endl;
+#if defined(HAVE_MPI_H)
+        // workers are waiting for jobs
+        for (int i = 1; i < num_process; i++) {
+            uint32_t stop = 0;
+            MPI_Send(&stop, 1, MPI_UNSIGNED, i, TAG_STOP, MPI_COMM_WORLD);
+        }
+#endif
         MPI_Finalize();
         return -1;
     }
+    vector<uint32_t> jobs;
+    result_map results;
+    make_jobs(opt, store, jobs, results);
+#if defined(HAVE_MPI_H)
+    if (num_process > 1) {
+        run_master(opt, store, num_process, jobs, results);
+    } else {
+        run_local(opt, store, jobs, results);
+    }
+#else
+    run_local(opt, store, jobs, results);
 #endif
     cout << "#" << genz_name(opt.genz_no) << endl;
     if (opt.original == 1) {
@@ -71,10 +118,13 @@ int main(int argc, char *argv[]) {
     cout << "#func_index = " << opt.genz_no << endl;
     cout << "#seed = " << opt.seed << endl;
     cout << endl;
-    for (uint32_t dim = opt.s_dim; dim <= opt.e_dim; dim += opt.add) {
-        if (static_cast<int>(dim) % num_process == rank) {
-            calc_theoretical(dim, opt.seed, opt.genz_no, opt.original);
-        }
+    for (result_map::iterator i = results.begin(); i != results.end(); ++i) {
+        cout << i->second;
+    }
+    if (!store.close()) {
+        store.reportError();
+        MPI_Finalize();
+        return -1;
     }
     MPI_Finalize();
     return 0;
@@ -90,6 +140,12 @@ namespace {
         cout << "\t--seed, -S\t\tseed of random" << endl;
         cout << "\t--genz-no, -g\t\tgenz-no" << endl;
         cout << "\t--orignal, -o\t\torignal genz parameters" << endl;
+        cout << "\t--db, -b\t\tsqlite3 database to store values" << endl;
+#if defined(HAVE_MPI_H)
+        cout << "with MPI, rank 0 hands out dims to the other ranks, "
+             << "largest first," << endl;
+        cout << "and writes all results to stdout in order of dim." << endl;
+#endif
     }
 
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
@@ -104,6 +160,7 @@ namespace {
             {"seed", required_argument, NULL, 'S'},
             {"genz-no", required_argument, NULL, 'g'},
             {"orignal", optional_argument, NULL, 'o'},
+            {"db", required_argument, NULL, 'b'},
             {NULL, 0, NULL, 0}};
         opt.s_dim = 0;
         opt.e_dim = 0;
@@ -113,7 +170,7 @@ namespace {
         opt.original = 0;
         errno = 0;
         for (;;) {
-            c = getopt_long(argc, argv, "s:e:a:S:g:o::", longopts, NULL);
+            c = getopt_long(argc, argv, "s:e:a:S:g:o::b:", longopts, NULL);
             if (error) {
                 break;
             }
@@ -170,6 +227,9 @@ namespace {
                     }
                 }
                 break;
+            case 'b':
+                opt.dbfile = optarg;
+                break;
             case '?':
             default:
                 error = true;
@@ -190,29 +250,186 @@ namespace {
         return true;
     }
 
-    int calc_theoretical(uint32_t dim, uint32_t seed, uint32_t genz_no,
-                         int original)
+    ResultKey make_key(const cmd_opt_t& opt, uint32_t dim)
     {
-        double *a = new double[dim];
-        double *b = new double[dim];
-        double *alpha = new double[dim];
-        double *beta = new double[dim];
-        for (size_t i = 0; i < dim; i++) {
-            a[i] = 0;
-            b[i] = 0;
-            alpha[i] = 0;
-            beta[i] = 0;
-        }
-        cout << "#dim = " << dim << endl;
-        makeParameter(genz_no, dim, seed, original,
+        ResultKey key;
+        key.program = "calc_theoretical";
+        key.s = dim;
+        key.m = 0;
+        key.genz_no = opt.genz_no;
+        key.seed = opt.seed;
+        key.shift = 0;
+        ostringstream params;
+        params << "original=" << opt.original;
+        key.params = params.str();
+        return key;
+    }
+
+    /**
+     * the same text as calc_theoretical() for a value of the store,
+     * the parameters are made again for it.
+     */
+    string stored_text(const cmd_opt_t& opt, uint32_t dim, double value)
+    {
+        MCQMCIntegration::Workspace work;
+        double *a = work.alloc(dim);
+        double *b = work.alloc(dim);
+        double *alpha = work.alloc(dim);
+        double *beta = work.alloc(dim);
+        ostringstream text;
+        text << "#dim = " << dim << endl;
+        print_parameter(opt, dim, text, a, b, alpha, beta);
+        text << "value = " << scientific << setprecision(18) << value
+             << endl;
+        text << endl;
+        return text.str();
+    }
+
+    /**
+     * make the parameters of dim, which makeParameter prints to out.
+     */
+    void print_parameter(const cmd_opt_t& opt, uint32_t dim, ostream& out,
+                         double a[], double b[], double alpha[],
+                         double beta[])
+    {
+        // makeParameter prints the parameters to cout
+        streambuf *save = cout.rdbuf(out.rdbuf());
+        makeParameter(opt.genz_no, dim, opt.seed, opt.original,
                       a, b, alpha, beta, true);
-        double value = genz_integral(genz_no, dim, a, b, alpha, beta);
-        cout << "value = " << scientific << setprecision(18) << value << endl;
-        cout << endl;
-        delete[] a;
-        delete[] b;
-        delete[] alpha;
-        delete[] beta;
-        return 0;
+        cout.rdbuf(save);
     }
+
+    /**
+     * calculate the integral of dim.
+     * @param text output for dim, including the parameters.
+     * @return the integral
+     */
+    double calc_theoretical(const cmd_opt_t& opt, uint32_t dim,
+                            string& text)
+    {
+        MCQMCIntegration::Workspace work;
+        double *a = work.alloc(dim);
+        double *b = work.alloc(dim);
+        double *alpha = work.alloc(dim);
+        double *beta = work.alloc(dim);
+        ostringstream out;
+        out << "#dim = " << dim << endl;
+        print_parameter(opt, dim, out, a, b, alpha, beta);
+        double value = genz_integral(opt.genz_no, dim, a, b, alpha, beta);
+        out << "value = " << scientific << setprecision(18) << value << endl;
+        out << endl;
+        text = out.str();
+        return value;
+    }
+
+    /**
+     * dims not in the store, largest first.
+     * All the integrals and makeParameter take time linear in dim,
+     * so handing out large dims first keeps the last jobs short.
+     */
+    void make_jobs(const cmd_opt_t& opt, ResultStore& store,
+                   vector<uint32_t>& jobs, result_map& results)
+    {
+        for (uint32_t dim = opt.s_dim; dim <= opt.e_dim; dim += opt.add) {
+            double stored;
+            double error;
+            if (store.find(make_key(opt, dim), &stored, &error)) {
+                results[dim] = stored_text(opt, dim, stored);
+            } else {
+                jobs.push_back(dim);
+            }
+            if (opt.add == 0) {
+                break;
+            }
+        }
+        sort(jobs.begin(), jobs.end(), greater<uint32_t>());
+    }
+
+    void run_local(const cmd_opt_t& opt, ResultStore& store,
+                   const vector<uint32_t>& jobs, result_map& results)
+    {
+        for (size_t i = 0; i < jobs.size(); i++) {
+            double value = calc_theoretical(opt, jobs[i], results[jobs[i]]);
+            if (!store.add(make_key(opt, jobs[i]), value, NAN)
+                || !store.flush()) {
+                store.reportError();
+            }
+        }
+    }
+
+#if defined(HAVE_MPI_H)
+    /*
+     * rank 0 sends a dim by TAG_JOB to each idle worker, and a worker
+     * returns the value by TAG_VALUE and the text by TAG_TEXT, then
+     * waits for the next job. TAG_STOP ends the worker.
+     */
+    void run_master(const cmd_opt_t& opt, ResultStore& store,
+                    int num_process, const vector<uint32_t>& jobs,
+                    result_map& results)
+    {
+        size_t next = 0;
+        int running = 0;
+        for (int i = 1; i < num_process; i++) {
+            uint32_t dim = 0;
+            if (next < jobs.size()) {
+                dim = jobs[next++];
+                MPI_Send(&dim, 1, MPI_UNSIGNED, i, TAG_JOB, MPI_COMM_WORLD);
+                running++;
+            } else {
+                MPI_Send(&dim, 1, MPI_UNSIGNED, i, TAG_STOP, MPI_COMM_WORLD);
+            }
+        }
+        while (running > 0) {
+            MPI_Status status;
+            double result[2];
+            MPI_Recv(result, 2, MPI_DOUBLE, MPI_ANY_SOURCE, TAG_VALUE,
+                     MPI_COMM_WORLD, &status);
+            int worker = status.MPI_SOURCE;
+            int length;
+            MPI_Probe(worker, TAG_TEXT, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_CHAR, &length);
+            vector<char> text(length);
+            MPI_Recv(&text[0], length, MPI_CHAR, worker, TAG_TEXT,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            uint32_t dim = static_cast<uint32_t>(result[0]);
+            results[dim].assign(text.begin(), text.end());
+            if (!store.add(make_key(opt, dim), result[1], NAN)
+                || !store.flush()) {
+                store.reportError();
+            }
+            running--;
+            dim = 0;
+            if (next < jobs.size()) {
+                dim = jobs[next++];
+                MPI_Send(&dim, 1, MPI_UNSIGNED, worker, TAG_JOB,
+                         MPI_COMM_WORLD);
+                running++;
+            } else {
+                MPI_Send(&dim, 1, MPI_UNSIGNED, worker, TAG_STOP,
+                         MPI_COMM_WORLD);
+            }
+        }
+    }
+
+    void run_worker(const cmd_opt_t& opt)
+    {
+        for (;;) {
+            uint32_t dim;
+            MPI_Status status;
+            MPI_Recv(&dim, 1, MPI_UNSIGNED, 0, MPI_ANY_TAG, MPI_COMM_WORLD,
+                     &status);
+            if (status.MPI_TAG != TAG_JOB) {
+                break;
+            }
+            string text;
+            double result[2];
+            result[0] = dim;
+            result[1] = calc_theoretical(opt, dim, text);
+            MPI_Send(result, 2, MPI_DOUBLE, 0, TAG_VALUE, MPI_COMM_WORLD);
+            MPI_Send(const_cast<char *>(text.data()),
+                     static_cast<int>(text.size()), MPI_CHAR, 0, TAG_TEXT,
+                     MPI_COMM_WORLD);
+        }
+    }
+#endif
 }
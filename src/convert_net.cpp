@@ -0,0 +1,189 @@
+#include <cerrno>
+#include <getopt.h>
+#include <cstdlib>
+#include <string>
+#include <MCQMCIntegration/DigitalNet.h>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include "net_file.h"
+
+using namespace std;
+using namespace MCQMCIntegration;
+
+/*
+ * convert digital net file of text format in README to binary format
+ * of net_file.h, or show the header of binary file.
+ */
+namespace {
+    struct cmd_opt_t {
+        bool info;
+        uint32_t flags;
+        double wafom;
+        int tvalue;
+        string input;
+        string output;
+    };
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
+    void cmd_message(const string& pgm);
+    int convert(cmd_opt_t& opt);
+    int info(const cmd_opt_t& opt);
+}
+
+int main(int argc, char *argv[])
+{
+    cmd_opt_t opt;
+    if (!parse_opt(opt, argc, argv)) {
+        return -1;
+    }
+    if (opt.info) {
+        return info(opt);
+    }
+    return convert(opt);
+}
+
+namespace {
+    int convert(cmd_opt_t& opt)
+    {
+        ifstream dnstream(opt.input);
+        if (!dnstream) {
+            cout << "can't open " << opt.input << endl;
+            return -1;
+        }
+        // the order of rows is the one of DigitalNet::getBase
+        DigitalNet<uint64_t> dn(dnstream);
+        int s = dn.getS();
+        int m = dn.getM();
+        vector<uint64_t> mat(static_cast<size_t>(s) * m);
+        for (int i = 0; i < m; i++) {
+            for (int j = 0; j < s; j++) {
+                mat[i * s + j] = dn.getBase(i, j);
+            }
+        }
+        // mean WAFOM and t-value after the matrix, if not given
+        ifstream tail(opt.input);
+        string word;
+        for (size_t i = 0; i < 3 + mat.size(); i++) {
+            tail >> word;
+        }
+        double wafom;
+        int tvalue;
+        if (!(opt.flags & NET_FILE_WAFOM) && (tail >> wafom)) {
+            opt.wafom = wafom;
+            opt.flags |= NET_FILE_WAFOM;
+            if (!(opt.flags & NET_FILE_TVALUE) && (tail >> tvalue)) {
+                opt.tvalue = tvalue;
+                opt.flags |= NET_FILE_TVALUE;
+            }
+        }
+        if (!write_net_file(opt.output, s, m, &mat[0], opt.flags,
+                            opt.wafom, opt.tvalue)) {
+            cout << "can't write " << opt.output << endl;
+            return -1;
+        }
+        return 0;
+    }
+
+    int info(const cmd_opt_t& opt)
+    {
+        NetFile file;
+        if (!file.open(opt.input)) {
+            cout << file.errorMessage() << endl;
+            return -1;
+        }
+        const NetFileHeader& header = file.getHeader();
+        cout << "version = " << dec << header.version << endl;
+        cout << "bit_width = " << header.bit_width << endl;
+        cout << "s = " << header.s << endl;
+        cout << "m = " << header.m << endl;
+        if (file.hasWafom()) {
+            cout << "wafom = " << setprecision(17) << header.wafom << endl;
+        }
+        if (file.hasTValue()) {
+            cout << "tvalue = " << header.tvalue << endl;
+        }
+        cout << "checksum = " << hex << header.checksum << dec << endl;
+        return 0;
+    }
+
+    void cmd_message(const string& pgm)
+    {
+        cout << pgm << " [-w wafom] [-t tvalue] text_file binary_file"
+             << endl;
+        cout << pgm << " -i binary_file" << endl;
+        cout << "\t--wafom, -w\tWAFOM of the net, default is the item"
+             << " after the matrix" << endl;
+        cout << "\t--tvalue, -t\tt-value of the net, default is the item"
+             << " after WAFOM" << endl;
+        cout << "\t--info, -i\tcheck binary_file and show its header"
+             << endl;
+    }
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
+    {
+        int c;
+        bool error = false;
+        string pgm = argv[0];
+        static struct option longopts[] = {
+            {"wafom", required_argument, NULL, 'w'},
+            {"tvalue", required_argument, NULL, 't'},
+            {"info", no_argument, NULL, 'i'},
+            {NULL, 0, NULL, 0}};
+        opt.info = false;
+        opt.flags = 0;
+        opt.wafom = 0;
+        opt.tvalue = 0;
+        errno = 0;
+        for (;;) {
+            c = getopt_long(argc, argv, "w:t:i", longopts, NULL);
+            if (error) {
+                break;
+            }
+            if (c == -1) {
+                break;
+            }
+            switch (c) {
+            case 'w':
+                opt.wafom = strtod(optarg, NULL);
+                opt.flags |= NET_FILE_WAFOM;
+                if (errno) {
+                    cout << "wafom should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 't':
+                opt.tvalue = strtol(optarg, NULL, 10);
+                opt.flags |= NET_FILE_TVALUE;
+                if (errno) {
+                    cout << "tvalue should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'i':
+                opt.info = true;
+                break;
+            case '?':
+            default:
+                error = true;
+                break;
+            }
+        }
+        argc -= optind;
+        argv += optind;
+        if (opt.info && argc == 1) {
+            opt.input = argv[0];
+        } else if (!opt.info && argc == 2) {
+            opt.input = argv[0];
+            opt.output = argv[1];
+        } else {
+            error = true;
+        }
+        if (error) {
+            cmd_message(pgm);
+            return false;
+        }
+        return true;
+    }
+}
@@ -1,14 +1,154 @@
-#include <stdint.h>
+#include <cstddef>
 #include <cmath>
+#include "corner_expect.h"
 
-// 森 修論 いや無理だわこれ
-double cornerpeak_expect(int dim, double alpha[], double *)
+/*
+ * The alternating sum over the 2^dim corners
+ *   (-1)^dim / dim! * sum_T (-1)^(dim - |T|) / (1 + sum_{j in T} alpha_j)
+ * is rewritten by 1 / x = int_0^inf exp(-t x) dt as
+ *   1 / dim! * int_0^inf exp(-t) prod_j (1 - exp(-t alpha_j)) dt,
+ * whose integrand is positive, so there is no cancellation.
+ *
+ * With t = exp(u) the integrand becomes exp(phi(u)),
+ *   phi(u) = u - t + sum_j log(1 - exp(-t alpha_j)),
+ * which is strictly concave in u, decays exponentially as u -> -inf and
+ * doubly exponentially as u -> inf. It is integrated by the trapezoidal
+ * rule around the peak of phi, which converges exponentially for such
+ * functions. Everything is done in log scale and long double so that
+ * 1 / dim! does not underflow before the end.
+ */
+
+namespace {
+    typedef long double real;
+
+    // phi(u) and its derivatives
+    void corner_phi(int dim, const double alpha[], real u,
+                    real *phi, real *d1, real *d2)
+    {
+        real t = expl(u);
+        real p = u - t;
+        real p1 = 1 - t;
+        real p2 = - t;
+        for (int j = 0; j < dim; j++) {
+            real x = t * alpha[j];
+            real q; // x / (exp(x) - 1)
+            if (x > 64) {
+                // log(1 - exp(-x)) = -exp(-x) in long double, and
+                // expm1(x) overflows for large x.
+                real e = expl(-x);
+                p -= e;
+                q = x * e;
+            } else {
+                real em1 = expm1l(x);
+                // log(1 - exp(-x)) = log(expm1(x)) - x
+                p += logl(em1) - x;
+                q = x / em1;
+            }
+            if (d1 != NULL) {
+                p1 += q;
+                p2 += q - x * q - q * q;
+            }
+        }
+        *phi = p;
+        if (d1 != NULL) {
+            *d1 = p1;
+            *d2 = p2;
+        }
+    }
+
+    // maximum point of phi, phi' is decreasing
+    real corner_peak(int dim, const double alpha[])
+    {
+        real lo = -700;
+        real hi = logl(static_cast<real>(dim) + 2);
+        real u = (lo + hi) / 2;
+        for (int i = 0; i < 200; i++) {
+            real p, d1, d2;
+            corner_phi(dim, alpha, u, &p, &d1, &d2);
+            if (d1 > 0) {
+                lo = u;
+            } else {
+                hi = u;
+            }
+            real next = u - d1 / d2;
+            if (!(next > lo && next < hi)) {
+                next = (lo + hi) / 2;
+            }
+            if (fabsl(next - u) <= 1e-15L * (1 + fabsl(u))) {
+                return next;
+            }
+            u = next;
+        }
+        return u;
+    }
+
+    // sum of exp(phi(u) - top) for u = center + (offset + k) * h
+    // in both directions until the terms are negligible.
+    real corner_sum(int dim, const double alpha[], real center, real top,
+                    real h, real offset)
+    {
+        const real cut = -80;
+        real sum = 0;
+        for (int k = 0; ; k++) {
+            real p;
+            corner_phi(dim, alpha, center + (offset + k) * h, &p, NULL, NULL);
+            p -= top;
+            sum += expl(p);
+            if (!(p >= cut)) {
+                break;
+            }
+        }
+        for (int k = -1; ; k--) {
+            real p;
+            corner_phi(dim, alpha, center + (offset + k) * h, &p, NULL, NULL);
+            p -= top;
+            sum += expl(p);
+            if (!(p >= cut)) {
+                break;
+            }
+        }
+        return sum;
+    }
+}
+
+double cornerpeak_expect(int dim, const double alpha[])
 {
-    uint64_t max = 2;
-    max = max << s;
-    double fact = 1.0;
-    for (int i = 0; i <
-    for (uint64_t x = 0; x < max; x++) {
+    for (int j = 0; j < dim; j++) {
+        if (!(alpha[j] > 0)) {
+            return 0.0;
+        }
+    }
+    real center = corner_peak(dim, alpha);
+    real top, d1, d2;
+    corner_phi(dim, alpha, center, &top, &d1, &d2);
+    // width of the peak
+    real h = 0.5L / sqrtl(- d2);
+    real sum = corner_sum(dim, alpha, center, top, h, 0);
+    real value = sum * h;
+    // the error of the trapezoidal rule is already far below the
+    // rounding error of phi at the first step, refinement is a check.
+    for (int i = 0; i < 10; i++) {
+        // add the midpoints
+        sum += corner_sum(dim, alpha, center, top, h, 0.5L);
+        h = h / 2;
+        real next = sum * h;
+        bool done = fabsl(next - value) <= 1e-15L * next;
+        value = next;
+        if (done) {
+            break;
+        }
+    }
+    return static_cast<double>(expl(logl(value) + top
+                                     - lgammal(dim + 1.0L)));
+}
 
+double oscillatory_expect(int dim, double c, const double alpha[])
+{
+    double sum = 0;
+    double prod = 1;
+    for (int j = 0; j < dim; j++) {
+        sum += alpha[j] / 2;
+        prod *= 2 * sin(alpha[j] / 2);
     }
+    return cos(c + sum) * prod;
 }
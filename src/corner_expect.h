@@ -0,0 +1,24 @@
+#pragma once
+#ifndef CORNER_EXPECT_H
+#define CORNER_EXPECT_H
+
+/**
+ * integral of Genz Corner Peak, the same value as the sum over 2^dim
+ * corners, computed by a one dimensional integral in O(dim) per node.
+ * @param dim dimension
+ * @param alpha parameters, positive
+ */
+double cornerpeak_expect(int dim, const double alpha[]);
+
+/**
+ * sum over 2^dim corners used by Genz Oscillatory, that is
+ * cos(c + sum_j alpha_j / 2) * prod_j 2 sin(alpha_j / 2).
+ * The integral of cos(c + sum_j alpha_j z_j) is this divided by
+ * prod_j alpha_j.
+ * @param dim dimension
+ * @param c constant term, 2 pi beta_1
+ * @param alpha parameters
+ */
+double oscillatory_expect(int dim, double c, const double alpha[]);
+
+#endif // CORNER_EXPECT_H
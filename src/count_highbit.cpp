@@ -10,8 +10,14 @@
 #include <fstream>
 #include "kahan.hpp"
 #include "RandomNet.hpp"
+#include "GrayCodeNet.hpp"
+#include "net_file.h"
+#include "bit_planes.hpp"
 #include <memory>
 #include <random>
+#include <vector>
+#include <algorithm>
+#include <thread>
 
 
 using namespace std;
@@ -20,6 +26,11 @@ using namespace MCQMCIntegration;
 //#define DEBUG
 
 namespace {
+    // number of points copied from the net at once, a word of bit plane
+    const int block_size = 64;
+    // patterns of at most this bits are counted by bit planes
+    const int max_pattern_bits = 4;
+
     struct cmd_opt_t {
         uint32_t s_dim;
         uint32_t start_m;
@@ -28,18 +39,20 @@ namespace {
         int dn_id;
         char type;
         bool verbose;
+        int threads;
         string dnfile;
     };
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
     void cmd_message(const string& pgm);
     template<typename D>
-    void counter1(D& digitalNet, int m, int count, const string& dn_name);
+    void counter1(D& digitalNet, int m, int count, int threads,
+                  const string& dn_name);
     template<typename D>
     void counterh(D& digitalNet, int count, int bits, int offset,
-                  const string& dn_name);
+                  int threads, const string& dn_name);
     template<typename D>
     void counterv(D& digitalNet, int m, int count, int bits, int offset,
-                  const string& dn_name);
+                  int threads, const string& dn_name);
     int file_sai(cmd_opt_t& opt);
     int random_sai(cmd_opt_t& opt);
 }
@@ -66,14 +79,16 @@ int main(int argc, char *argv[]) {
 #endif
     DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
     DigitalNet<uint64_t> dn(dnid, opt.s_dim, opt.start_m);
+    GrayCodeNet gc(dn);
     int count = 1 << opt.start_m;
     if (opt.type == '1') {
-        counter1(dn, opt.start_m, count, getDigitalNetName(opt.dn_id));
+        counter1(gc, opt.start_m, count, opt.threads,
+                 getDigitalNetName(opt.dn_id));
     } else if (opt.type == 'v') {
-        counterv(dn, opt.start_m, count, opt.bits, opt.offset,
+        counterv(gc, opt.start_m, count, opt.bits, opt.offset, opt.threads,
                  getDigitalNetName(opt.dn_id));
     } else {
-        counterh(dn, count, opt.bits, opt.offset,
+        counterh(gc, count, opt.bits, opt.offset, opt.threads,
                  getDigitalNetName(opt.dn_id));
     }
     return 0;
@@ -82,6 +97,30 @@ int main(int argc, char *argv[]) {
 namespace {
     int file_sai(cmd_opt_t& opt)
     {
+        if (is_net_file(opt.dnfile)) {
+            NetFile file;
+            if (!file.open(opt.dnfile)) {
+                cout << file.errorMessage() << endl;
+                return -1;
+            }
+            if (static_cast<uint32_t>(file.getS()) != opt.s_dim) {
+                cout << "s_dim != dn.getS()" << endl;
+                return -1;
+            }
+            int m = file.getM();
+            int count = 1 << m;
+            GrayCodeNet gc(file.getS(), m, file.getBase());
+            if (opt.type == '1') {
+                counter1(gc, m, count, opt.threads, opt.dnfile);
+            } else if (opt.type == 'v') {
+                counterv(gc, m, count, opt.bits, opt.offset, opt.threads,
+                         opt.dnfile);
+            } else {
+                counterh(gc, count, opt.bits, opt.offset, opt.threads,
+                         opt.dnfile);
+            }
+            return 0;
+        }
         ifstream dnstream(opt.dnfile);
         if (!dnstream) {
             cout << "can't open digital_net_file" << endl;
@@ -98,12 +137,15 @@ namespace {
         }
         int m = dn.getM();
         int count = 1 << m;
+        GrayCodeNet gc(dn);
         if (opt.type == '1') {
-            counter1(dn, m, count, opt.dnfile);
+            counter1(gc, m, count, opt.threads, opt.dnfile);
         } else if (opt.type == 'v') {
-            counterv(dn, m, count, opt.bits, opt.offset, opt.dnfile);
+            counterv(gc, m, count, opt.bits, opt.offset, opt.threads,
+                     opt.dnfile);
         } else {
-            counterh(dn, count, opt.bits, opt.offset, opt.dnfile);
+            counterh(gc, count, opt.bits, opt.offset, opt.threads,
+                     opt.dnfile);
         }
         return 0;
     }
@@ -116,12 +158,14 @@ namespace {
         int mask = 64;
         dn.setMask(mask);
         int count = 1 << opt.start_m;
+        // random points are made in order, so threads are not used
         if (opt.type == '1') {
-            counter1(dn, opt.start_m, count, "Random");
+            counter1(dn, opt.start_m, count, 1, "Random");
         } else if (opt.type == 'v') {
-            counterv(dn, opt.start_m, count, opt.bits, opt.offset, "Random");
+            counterv(dn, opt.start_m, count, opt.bits, opt.offset, 1,
+                     "Random");
         } else {
-            counterh(dn, count, opt.bits, opt.offset, "Random");
+            counterh(dn, count, opt.bits, opt.offset, 1, "Random");
         }
         return 0;
     }
@@ -129,7 +173,9 @@ namespace {
     void cmd_message(const string& pgm)
     {
         cout << pgm << " -s s_dim -m start_m -t type [-b bits] [-o offset]"
-             << " [-d digitalnet_id] [-v] [digitalnet_file]" << endl;
+             << " [-d digitalnet_id] [-j threads] [-v] [digitalnet_file]"
+             << endl;
+        cout << "\t--threads, -j\tsplit points among threads" << endl;
     }
 
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
@@ -148,6 +194,7 @@ namespace {
             {"offset", required_argument, NULL, 'o'},
             {"digitalnet-id", required_argument, NULL, 'd'},
             {"verbose", no_argument, NULL, 'v'},
+            {"threads", required_argument, NULL, 'j'},
             {NULL, 0, NULL, 0}};
         opt.s_dim = 0;
         opt.start_m = 0;
@@ -156,12 +203,13 @@ namespace {
         opt.bits = 3;
         opt.offset = 0;
         opt.verbose = false;
+        opt.threads = 1;
         errno = 0;
 #if defined(DEBUG)
         cout << "parse_opt step 2" << endl;
 #endif
         for (;;) {
-            c = getopt_long(argc, argv, "s:m:t:b:o:d:v", longopts, NULL);
+            c = getopt_long(argc, argv, "s:m:t:b:o:d:vj:", longopts, NULL);
             if (error) {
                 break;
             }
@@ -210,6 +258,13 @@ namespace {
             case 'v':
                 opt.verbose = true;
                 break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
             case '?':
             default:
                 error = true;
@@ -237,9 +292,120 @@ namespace {
         return true;
     }
 
+    /**
+     * split count points into contiguous ranges and call
+     * count_range(part, cursor, n) for each range by a thread,
+     * cursor is a copy of net moved to the first point of the range.
+     * @return number of ranges, at most threads
+     */
+    template<typename F>
+    int split_points(GrayCodeNet& net, int count, int threads,
+                     F count_range)
+    {
+        threads = max(1, min(threads, count / block_size));
+        // ranges are made of whole blocks
+        int chunk = (count / threads) & ~(block_size - 1);
+        vector<thread> workers;
+        for (int k = 0; k < threads; k++) {
+            int first = chunk * k;
+            int n = chunk;
+            if (k == threads - 1) {
+                n = count - first;
+            }
+            workers.push_back(thread([&net, &count_range, k, first, n]() {
+                        GrayCodeNet cursor(net);
+                        cursor.setIndex(first);
+                        count_range(k, cursor, n);
+                    }));
+        }
+        for (int k = 0; k < threads; k++) {
+            workers[k].join();
+        }
+        return threads;
+    }
+
+    template<typename F>
+    int split_points(RandomNet& net, int count, int, F count_range)
+    {
+        count_range(0, net, count);
+        return 1;
+    }
+
+    /**
+     * read n points of cursor block by block and call
+     * block(planes, valid) for each block, where planes[j * 64 + k] is
+     * the bit plane of k-th bit after the binary point of j-th
+     * coordinate, see transpose64(), and valid is the mask of the points
+     * in the block.
+     */
+    template<typename D, typename F>
+    void transpose_blocks(D& cursor, int n, int s, F block)
+    {
+        vector<uint64_t> buf(static_cast<size_t>(block_size) * s);
+        vector<uint64_t> planes(static_cast<size_t>(block_size) * s);
+        for (int i = 0; i < n; i += block_size) {
+            int c = min(block_size, n - i);
+            cursor.fillBase(&buf[0], c);
+            for (int j = 0; j < s; j++) {
+                uint64_t *plane = &planes[static_cast<size_t>(j) * 64];
+                for (int p = 0; p < c; p++) {
+                    plane[p] = buf[static_cast<size_t>(p) * s + j];
+                }
+                for (int p = c; p < 64; p++) {
+                    plane[p] = 0;
+                }
+                transpose64(plane);
+            }
+            block(&planes[0], plane_mask(c));
+        }
+    }
+
+    /**
+     * the same as transpose_blocks(), planes for k < depth are needed.
+     */
+    template<typename D, typename F>
+    void for_plane_blocks(D& cursor, int n, int s, int, F block)
+    {
+        transpose_blocks(cursor, n, s, block);
+    }
+
+    /**
+     * the planes are made by GrayCodePlanes without reading points
+     * if the blocks are aligned.
+     */
+    template<typename F>
+    void for_plane_blocks(GrayCodeNet& cursor, int n, int s, int depth,
+                          F block)
+    {
+        uint64_t first = cursor.getIndex();
+        if (!GrayCodePlanes::usable(cursor) || first % block_size != 0) {
+            transpose_blocks(cursor, n, s, block);
+            return;
+        }
+        GrayCodePlanes gp(cursor, depth);
+        for (int i = 0; i < n; i += block_size) {
+            block(gp.getPlanes(first + i), plane_mask(n - i));
+        }
+    }
+
+    /**
+     * add the tables of ranges counted by threads.
+     */
+    void merge_parts(const vector<uint64_t>& partial, int parts,
+                     vector<uint64_t>& sum)
+    {
+        size_t size = sum.size();
+        for (int k = 0; k < parts; k++) {
+            for (size_t i = 0; i < size; i++) {
+                sum[i] += partial[k * size + i];
+            }
+        }
+    }
+
     //ビットの数を数える
     template<typename D>
-    void counter1(D& digitalNet, int m, int count, const string& dn_name)
+    void counter1(D& digitalNet, int m, int count, int threads,
+                  const string& dn_name)
     {
 #if defined(DEBUG)
         cout << "count = " << dec << count << endl;
@@ -248,26 +414,25 @@ namespace {
         cout << "# " << dn_name << endl;
         cout << "# s = " << dec << s << endl;
         cout << "# count = " << dec << count << endl;
-        int sum[s][m];
-        for (int i = 0; i < s; i++) {
-            for (int j = 0; j < m; j++) {
-                sum[i][j] = 0;
-            }
-        }
+        size_t size = static_cast<size_t>(s) * m;
+        vector<uint64_t> sum(size, 0);
+        vector<uint64_t> partial(threads * size, 0);
         digitalNet.pointInitialize();
-        for (int i = 0; i < count; i++) {
-            const double *tuple = digitalNet.getPoint();
-            for (int j = 0; j < s; j++) {
-                double mag = 2;
-                for (int k = 0; k < m; k++) {
-                    if (static_cast<uint32_t>(tuple[j] * mag) & 1) {
-                        sum[j][k] += 1;
+        int parts = split_points(digitalNet, count, threads,
+                                 [&](int t, auto& cursor, int n) {
+            uint64_t *part = &partial[t * size];
+            for_plane_blocks(cursor, n, s, m, [&](const uint64_t planes[],
+                                                  uint64_t valid) {
+                for (int j = 0; j < s; j++) {
+                    const uint64_t *plane = &planes[j * 64];
+                    // k-th bit after the binary point
+                    for (int k = 0; k < m; k++) {
+                        part[j * m + k] += popcount64(plane[k] & valid);
                     }
-                    mag = mag * 2;
                 }
-            }
-            digitalNet.nextPoint();
-        }
+            });
+        });
+        merge_parts(partial, parts, sum);
         cout << "#s, ";
         for (int i = 0; i < m; i++) {
             cout << dec << i << ", ";
@@ -276,7 +441,7 @@ namespace {
         for (int i = 0; i < s; i++) {
             cout << dec << i << ", ";
             for (int j = 0; j < m; j++) {
-                cout << dec << sum[i][j] << ",";
+                cout << dec << sum[i * m + j] << ",";
             }
             cout << endl;
         }
@@ -284,7 +449,7 @@ namespace {
     // 横方向にカウントする
     template<typename D>
     void counterh(D& digitalNet, int count, int bits, int offset,
-                  const string& dn_name)
+                  int threads, const string& dn_name)
     {
 #if defined(DEBUG)
         cout << "count = " << dec << count << endl;
@@ -295,23 +460,41 @@ namespace {
         cout << "# offset = " << dec << offset << endl;
         cout << "# count = " << dec << count << endl;
         int k = 1 << bits;
-        int o = 1 << offset;
-        int omask = k - 1;
-        int sum[s][k];
-        for (int i = 0; i < s; i++) {
-            for (int j = 0; j < k; j++) {
-                sum[i][j] = 0;
-            }
-        }
+        uint64_t omask = k - 1;
+        size_t size = static_cast<size_t>(s) * k;
+        vector<uint64_t> sum(size, 0);
+        vector<uint64_t> partial(threads * size, 0);
+        int shift = 64 - bits - offset;
+        bool by_planes = bits <= max_pattern_bits && shift >= 0;
         digitalNet.pointInitialize();
-        for (int i = 0; i < count; i++) {
-            const double *tuple = digitalNet.getPoint();
-            for (int j = 0; j < s; j++) {
-                int mask = static_cast<int>(tuple[j] * k * o) & omask;
-                sum[j][mask] += 1;
+        int parts = split_points(digitalNet, count, threads,
+                                 [&](int t, auto& cursor, int n) {
+            uint64_t *part = &partial[t * size];
+            if (by_planes) {
+                uint64_t work[1 << max_pattern_bits];
+                for_plane_blocks(cursor, n, s, offset + bits,
+                                 [&](const uint64_t planes[],
+                                     uint64_t valid) {
+                    for (int j = 0; j < s; j++) {
+                        count_patterns(&planes[j * 64 + offset], bits, valid,
+                                       &part[j * k], work);
+                    }
+                });
+                return;
             }
-            digitalNet.nextPoint();
-        }
+            vector<uint64_t> buf(static_cast<size_t>(block_size) * s);
+            for (int i = 0; i < n; i += block_size) {
+                int c = min(block_size, n - i);
+                cursor.fillBase(&buf[0], c);
+                for (int p = 0; p < c; p++) {
+                    const uint64_t *tuple = &buf[static_cast<size_t>(p) * s];
+                    for (int j = 0; j < s; j++) {
+                        part[j * k + ((tuple[j] >> shift) & omask)] += 1;
+                    }
+                }
+            }
+        });
+        merge_parts(partial, parts, sum);
         cout << "#s, ";
         for (int i = 0; i < k; i++) {
             cout << dec << i << ", ";
@@ -320,7 +503,7 @@ namespace {
         for (int i = 0; i < s; i++) {
             cout << dec << i << ", ";
             for (int j = 0; j < k; j++) {
-                cout << dec << sum[i][j] << ",";
+                cout << dec << sum[i * k + j] << ",";
             }
             cout << endl;
         }
@@ -329,7 +512,7 @@ namespace {
     // 縦方向にカウントする（全部は無理）
     template<typename D>
     void counterv(D& digitalNet, int m, int count, int bits, int offset,
-                  const string& dn_name)
+                  int threads, const string& dn_name)
     {
 #if defined(DEBUG)
         cout << "count = " << dec << count << endl;
@@ -341,46 +524,50 @@ namespace {
         cout << "# m = " << dec << m << endl;
         cout << "# count = " << dec << count << endl;
         int c = 1 << bits;
-        uint64_t sum[m][c];
-        for (int i = 0; i < m; i++) {
-            for (int j = 0; j < c; j++) {
-                sum[i][j] = 0;
-            }
-        }
+        size_t size = static_cast<size_t>(m) * c;
+        vector<uint64_t> sum(size, 0);
+        vector<uint64_t> partial(threads * size, 0);
+        // coordinates offset, ..., end - 1 make the pattern
+        int end = min(offset + bits, s);
+        int used = max(0, end - offset);
         digitalNet.pointInitialize();
-#if defined(DEBUG)
-        cout << "counter v step 1 c = " << dec << c << endl;
-#endif
         // このへんからよく考える
-        for (int i = 0; i < count; i++) {
-            const double *tuple = digitalNet.getPoint();
-            double mag = 2;
-            for (int j = 0; j < m; j++) {
-#if defined(DEBUG)
-                cout << "j, m = " << dec << j << "," << m << endl;
-#endif
-                int kei = 0;
-                //for (int k = 0; k < s && k < bits; k++) {
-                for (int k = offset; k < offset + bits && k < s; k++) {
-                    kei = kei << 1;
-                    if (static_cast<int>(tuple[k] * mag) & 1) {
-                        kei += 1;
+        int parts = split_points(digitalNet, count, threads,
+                                 [&](int t, auto& cursor, int n) {
+            uint64_t *part = &partial[t * size];
+            if (used <= max_pattern_bits) {
+                uint64_t work[1 << max_pattern_bits];
+                uint64_t plane[max_pattern_bits];
+                for_plane_blocks(cursor, n, s, m,
+                                 [&](const uint64_t planes[],
+                                     uint64_t valid) {
+                    for (int j = 0; j < m; j++) {
+                        for (int b = 0; b < used; b++) {
+                            plane[b] = planes[(offset + b) * 64 + j];
+                        }
+                        count_patterns(plane, used, valid, &part[j * c],
+                                       work);
+                    }
+                });
+                return;
+            }
+            vector<uint64_t> buf(static_cast<size_t>(block_size) * s);
+            for (int i = 0; i < n; i += block_size) {
+                int cnt = min(block_size, n - i);
+                cursor.fillBase(&buf[0], cnt);
+                for (int p = 0; p < cnt; p++) {
+                    const uint64_t *tuple = &buf[static_cast<size_t>(p) * s];
+                    for (int j = 0; j < m; j++) {
+                        int kei = 0;
+                        for (int k = offset; k < end; k++) {
+                            kei = (kei << 1) | ((tuple[k] >> (63 - j)) & 1);
+                        }
+                        part[j * c + kei] += 1;
                     }
                 }
-#if defined(DEBUG)
-                cout << "j, kei = " << dec << j << "," << kei << endl;
-#endif
-                sum[j][kei] += 1;
-                mag = mag * 2;
             }
-#if defined(DEBUG)
-            cout << "before nextPoint" << endl;
-#endif
-            digitalNet.nextPoint();
-        }
-#if defined(DEBUG)
-        cout << "counter v step 2 " << endl;
-#endif
+        });
+        merge_parts(partial, parts, sum);
         cout << "#m, ";
         for (int i = 0; i < c; i++) {
             cout << dec << i << ", ";
@@ -389,7 +576,7 @@ namespace {
         for (int i = 0; i < m; i++) {
             cout << dec << i << ", ";
             for (int j = 0; j < c; j++) {
-                cout << dec << sum[i][j] << ",";
+                cout << dec << sum[i * c + j] << ",";
             }
             cout << endl;
         }
@@ -3,6 +3,15 @@
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <map>
+#include <vector>
+#include <utility>
+#include <mutex>
+#include <thread>
+#include <atomic>
 #include "cvmean.h"
 
 using namespace std;
@@ -67,6 +76,17 @@ namespace {
         return x * y;
     }
 
+    /**
+     * log(e^x - 1) without overflow for large x.
+     */
+    double log_expm1(double x)
+    {
+        if (x > 30.0) {
+            return x + log1p(-exp(-x));
+        }
+        return log(expm1(x));
+    }
+
     /**
      * CVを計算する。今回はCが変わるのでキャッシュできないんだなぁ。
      * @param c
@@ -105,6 +125,118 @@ namespace {
         return mp * pr2 / pr1;
     }
 
+    /**
+     * log of calc_cv(). The products of pow(1 + p, s) are sums of
+     * log1p(p) here, so that they do not overflow for large s.
+     */
+    double calc_log_cv(int m, double c, int s, int n)
+    {
+        double mp = sqrt(pow(2.0, m) - 1.0);
+        double p22 = pow(2.0, 2.0 * (c - 1.0));
+        double p2 = pow(2.0, c - 1.0);
+        double log_pr2 = 0;
+        double log_pr1 = 0;
+        for (int j = 1; j <= n; j++) {
+            p22 = p22 / 4.0;
+            p2 = p2 / 2.0;
+            log_pr2 += log1p(p22);
+            log_pr1 += log1p(p2);
+        }
+        log_pr2 *= s;
+        log_pr1 *= s;
+        // log(mp * sqrt(pr2 - 1) / (pr1 - 1))
+        return log(mp) + 0.5 * log_expm1(log_pr2) - log_expm1(log_pr1);
+    }
+
+    /**
+     * root of calc_cv(m, c, s, n) = cv_mean in [c_min, c_max] by Brent's
+     * method, calc_cv is decreasing in c.
+     */
+    double brent_root(int m, int s, int n, double cv_mean,
+                      double c_min, double c_max)
+    {
+        const double log_mean = log(cv_mean);
+        double a = c_min;
+        double b = c_max;
+        double fa = calc_log_cv(m, a, s, n) - log_mean;
+        double fb = calc_log_cv(m, b, s, n) - log_mean;
+        double c = a;
+        double fc = fa;
+        double d = b - a;
+        double e = d;
+        for (int i = 0; i < 200; i++) {
+            if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+                c = a;
+                fc = fa;
+                d = b - a;
+                e = d;
+            }
+            if (abs(fc) < abs(fb)) {
+                a = b;
+                b = c;
+                c = a;
+                fa = fb;
+                fb = fc;
+                fc = fa;
+            }
+            // enough for the window of calc_c_and_cvmean()
+            double tol = 2.0 * DBL_EPSILON * abs(b) + 1e-10;
+            double half = (c - b) / 2.0;
+            if (abs(half) <= tol || fb == 0) {
+                return b;
+            }
+            if (abs(e) >= tol && abs(fa) > abs(fb)) {
+                // inverse quadratic interpolation or secant
+                double p;
+                double q;
+                double r = fb / fa;
+                if (a == c) {
+                    p = 2.0 * half * r;
+                    q = 1.0 - r;
+                } else {
+                    double t = fa / fc;
+                    double u = fb / fc;
+                    p = r * (2.0 * half * t * (t - u) - (b - a) * (u - 1.0));
+                    q = (t - 1.0) * (u - 1.0) * (r - 1.0);
+                }
+                if (p > 0) {
+                    q = -q;
+                } else {
+                    p = -p;
+                }
+                if (2.0 * p < min(3.0 * half * q - abs(tol * q),
+                                  abs(e * q))) {
+                    e = d;
+                    d = p / q;
+                } else {
+                    d = half;
+                    e = d;
+                }
+            } else {
+                d = half;
+                e = d;
+            }
+            a = b;
+            fa = fb;
+            if (abs(d) > tol) {
+                b += d;
+            } else {
+                b += half > 0 ? tol : -tol;
+            }
+            fb = calc_log_cv(m, b, s, n) - log_mean;
+        }
+        return b;
+    }
+
+    /**
+     * c of the bisection which was used before, the first midpoint
+     * whose CV is within FLT_EPSILON of cv_mean, so that c and the
+     * parameters made from it do not change.
+     * The root is found by brent_root(), and the midpoints far from
+     * the root go to the side of the root without calc_cv(), only
+     * the last few midpoints are evaluated by calc_cv(), whose rounding
+     * decides the midpoint at the edge of FLT_EPSILON.
+     */
     int calc_c_and_cvmean(double& c, double& cvmean,
                           int s, int n)
     {
@@ -114,27 +246,42 @@ namespace {
             c_min = -4.0;
         }
         double c_max = 10.0;
-        //double c_max =calc_c_cv_min(m, s, n);
-        //double cv_max = calc_cv_minus_inf_except_m(n, s);
         double cv_max = calc_cv_minus_inf(m, n, s);
-        //double cv_min = calc_c_cv_min(m, s, n, c_max);
         double cv_min = 0; // not a bug
-#if defined(DEBUG)
-        cout << "cv_max = " << cv_max << endl;
-        cout << "cv_min = " << cv_min << endl;
-        cout << "c_max = " << c_max << endl;
-        cout << "c_min = " << c_min << endl;
-#endif
         if (isnan(cv_max) || isnan(cv_min)) {
             return -1;
         }
         const double cv_mean = (cv_max + cv_min) / 2;
         cvmean = cv_mean;
         const double eps = FLT_EPSILON; // not a bug
-        //cout << "cv_mean = " << setprecision(18) << fixed << cv_mean << endl;
+        // for large s, the root is less than -10
+        while (calc_log_cv(m, c_min, s, n) <= log(cv_mean)) {
+            c_min -= 10.0;
+            if (c_min < -1000) {
+                cout << "can't calculate" << endl;
+                return -1;
+            }
+        }
+        const double root = brent_root(m, s, n, cv_mean, c_min, c_max);
+        // the midpoints within eps of cv_mean are in root +- eps / slope,
+        // window is much wider than it and the error of root
+        const double h = 1e-6;
+        double slope = cv_mean * (calc_log_cv(m, root - h, s, n)
+                                  - calc_log_cv(m, root + h, s, n)) / (2 * h);
+        const double window = max(1e-7, 32.0 * eps / slope);
+#if defined(DEBUG)
+        cout << "root = " << setprecision(18) << root << endl;
+#endif
         for (int i = 0; i < 1000; i++) {
             double c_tmp = (c_max + c_min) / 2.0;
-            //double cv_tmp = calc_cv_except_m(c_tmp, s, n);
+            if (c_tmp > root + window) {
+                c_max = c_tmp;
+                continue;
+            }
+            if (c_tmp < root - window) {
+                c_min = c_tmp;
+                continue;
+            }
             double cv_tmp = calc_cv(m, c_tmp, s, n);
             if (abs(cv_tmp - cv_mean) < eps) {
 #if defined(DEBUG)
@@ -144,45 +291,177 @@ namespace {
                 c = c_tmp;
                 return 0;
             }
-#if defined(DEBUG)
-            cout << "cv_mean = " << cv_mean << endl;
-            cout << "cv_tmp = " << cv_tmp << endl;
-#endif
             if (cv_tmp < cv_mean) {
                 c_max = c_tmp;
-#if defined(DEBUG)
-                cout << "*c_max = " << c_max << endl;
-                cout << "c_min = " << c_min << endl;
-#endif
             } else {
                 c_min = c_tmp;
-#if defined(DEBUG)
-                cout << "c_max = " << c_max << endl;
-                cout << "*c_min = " << c_min << endl;
-#endif
             }
         }
         cout << "can't calculate" << endl;
         return -1;
     }
+
+    typedef map<pair<int, int>, double> cache_t;
+    // c computed or loaded, key is (s, n)
+    cache_t cache;
+    mutex cache_mutex;
+    bool env_loaded = false;
+
+    /**
+     * read lines of "s n c" of file to cache, cache_mutex should be
+     * locked.
+     */
+    bool read_cache(const string& path)
+    {
+        ifstream ifs(path.c_str());
+        if (!ifs) {
+            return false;
+        }
+        string line;
+        while (getline(ifs, line)) {
+            istringstream iss(line);
+            int s;
+            int n;
+            double c;
+            if (iss >> s >> n >> c) {
+                cache[make_pair(s, n)] = c;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * load the file of CVMEAN_CACHE at the first call,
+     * cache_mutex should be locked.
+     * @return the file name, or NULL if CVMEAN_CACHE is not set
+     */
+    const char * env_cache()
+    {
+        const char *path = getenv("CVMEAN_CACHE");
+        if (path != NULL && !env_loaded) {
+            read_cache(path);
+        }
+        env_loaded = true;
+        return path;
+    }
+
+    bool find_cache(int s, int n, double *c)
+    {
+        cache_t::const_iterator it = cache.find(make_pair(s, n));
+        if (it == cache.end()) {
+            return false;
+        }
+        *c = it->second;
+        return true;
+    }
+
+    /**
+     * c of calc_c_and_cvmean(), throw if it fails.
+     */
+    double compute_c(int s, int n)
+    {
+        double c = 1.0;
+        double cvmean;
+        int r = calc_c_and_cvmean(c, cvmean, s, n);
+        if (r != 0) {
+            //throw runtime_error("calc_c_and_cvmean error");
+            throw "calc_c_and_cvmean error";
+        }
+        return c;
+    }
 }
 
 double calc_c_for_cvmean(int s, int n)
 {
     double c = 1.0;
-    double cvmean;
     if (s <= 0) {
         //throw runtime_error("s <= 0");
         throw "s <= 0";
     }
     if (s <= table_max) {
         return cv_mean_c[s];
-    } else {
-        int r = calc_c_and_cvmean(c, cvmean, s, n);
-        if (r != 0) {
-            //throw runtime_error("calc_c_and_cvmean error");
-            throw "calc_c_and_cvmean error";
+    }
+    const char *path;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        path = env_cache();
+        if (find_cache(s, n, &c)) {
+            return c;
+        }
+    }
+    c = compute_c(s, n);
+    lock_guard<mutex> lock(cache_mutex);
+    cache[make_pair(s, n)] = c;
+    if (path != NULL) {
+        ofstream ofs(path, ios::app);
+        ofs << s << " " << n << " " << setprecision(17) << c << endl;
+    }
+    return c;
+}
+
+bool cvmean_load_cache(const string& path)
+{
+    lock_guard<mutex> lock(cache_mutex);
+    return read_cache(path);
+}
+
+bool cvmean_save_cache(const string& path)
+{
+    lock_guard<mutex> lock(cache_mutex);
+    ofstream ofs(path.c_str(), ios::trunc);
+    ofs << setprecision(17);
+    for (cache_t::const_iterator it = cache.begin(); it != cache.end();
+         ++it) {
+        ofs << it->first.first << " " << it->first.second << " "
+            << it->second << "\n";
+    }
+    ofs.close();
+    return !ofs.fail();
+}
+
+int cvmean_fill(int max_s, int n, int threads)
+{
+    vector<int> todo;
+    {
+        lock_guard<mutex> lock(cache_mutex);
+        double c;
+        for (int s = table_max + 1; s <= max_s; s++) {
+            if (!find_cache(s, n, &c)) {
+                todo.push_back(s);
+            }
+        }
+    }
+    vector<double> result(todo.size());
+    vector<char> ok(todo.size(), 0);
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (;;) {
+            size_t i = next++;
+            if (i >= todo.size()) {
+                break;
+            }
+            try {
+                result[i] = compute_c(todo[i], n);
+                ok[i] = 1;
+            } catch (const char *) {
+            }
+        }
+    };
+    vector<thread> workers;
+    for (int k = 0; k < max(1, threads); k++) {
+        workers.push_back(thread(work));
+    }
+    for (size_t k = 0; k < workers.size(); k++) {
+        workers[k].join();
+    }
+    int failed = 0;
+    lock_guard<mutex> lock(cache_mutex);
+    for (size_t i = 0; i < todo.size(); i++) {
+        if (ok[i]) {
+            cache[make_pair(todo[i], n)] = result[i];
+        } else {
+            failed++;
         }
-        return c;
     }
+    return failed;
 }
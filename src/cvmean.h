@@ -2,6 +2,36 @@
 #ifndef CVMEAN_H
 #define CVMEAN_H
 
+#include <string>
+
+/**
+ * c of WAFOM parameters whose CV is the mean of CV.
+ * s <= 32 for n = 64 are in a table. Others are computed once and kept
+ * in memory, and also in the file of environment variable CVMEAN_CACHE
+ * if it is set, which is read at the first call.
+ * @param s dimension of R
+ * @param n number of bits, 32 or 64
+ * @return c
+ */
 double calc_c_for_cvmean(int s, int n);
 
+/**
+ * read lines of "s n c" to the memory of calc_c_for_cvmean().
+ * @return false if the file can't be opened
+ */
+bool cvmean_load_cache(const std::string& path);
+
+/**
+ * write all c in the memory of calc_c_for_cvmean() to path.
+ * @return false if the file can't be written
+ */
+bool cvmean_save_cache(const std::string& path);
+
+/**
+ * compute c for s = 33, ..., max_s not in memory by threads and
+ * keep them in memory.
+ * @return number of s whose c can't be computed
+ */
+int cvmean_fill(int max_s, int n, int threads);
+
 #endif // CVMEAN_H
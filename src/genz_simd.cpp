@@ -0,0 +1,401 @@
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include "genz_simd.h"
+
+using namespace std;
+
+/*
+ * Every kernel is compiled once for each instruction set in the list
+ * and the dynamic loader selects one for the running CPU.
+ * Loops over points have no loop-carried dependency and are
+ * vectorized; cos and exp are evaluated in a separate scalar pass.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) \
+    && defined(__linux__)
+#define GENZ_SIMD_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define GENZ_SIMD_CLONES
+#endif
+
+/*
+ * Kernels are templates on the dimension. S > 0 is the dimension fixed
+ * at compile time, so that loops over dimensions are unrolled and
+ * parameters are kept in registers; S = 0 is the generic kernel for
+ * other dimensions. The templates are inlined into the entry points,
+ * which select S from the run-time dimension, so that every clone for an
+ * instruction set has its own fixed dimension kernels.
+ */
+#if defined(__GNUC__)
+#define GENZ_INLINE inline __attribute__((always_inline))
+#else
+#define GENZ_INLINE inline
+#endif
+
+#define GENZ_DISPATCH(kernel, ndim, ...)            \
+    switch (ndim) {                                 \
+    case 4: kernel<4>(__VA_ARGS__); break;          \
+    case 8: kernel<8>(__VA_ARGS__); break;          \
+    case 16: kernel<16>(__VA_ARGS__); break;        \
+    case 32: kernel<32>(__VA_ARGS__); break;        \
+    case 64: kernel<64>(__VA_ARGS__); break;        \
+    default: kernel<0>(__VA_ARGS__); break;         \
+    }
+
+namespace {
+    // points of the working arrays on the stack, kernels which need them
+    // evaluate a larger block by chunks of this size
+    const int chunk_size = 256;
+
+    template<int S> GENZ_INLINE
+    void oscillatoryS(int ndim, int n, const double z[], const double w[],
+                      double c, double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        for (int i = 0; i < n; i++) {
+            value[i] = 0.0;
+        }
+        for (int j = 0; j < dim; j++) {
+            const double *x = &z[j * n];
+            const double a = w[j];
+            for (int i = 0; i < n; i++) {
+                value[i] += a * x[i];
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            value[i] = cos(c + value[i]);
+        }
+    }
+
+    template<int S> GENZ_INLINE
+    void productPeakS(int ndim, int n, const double z[],
+                      const double inv[], const double beta[],
+                      double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        for (int i = 0; i < n; i++) {
+            value[i] = 1.0;
+        }
+        for (int j = 0; j < dim; j++) {
+            const double *x = &z[j * n];
+            const double a = inv[j];
+            const double b = beta[j];
+            for (int i = 0; i < n; i++) {
+                const double d = x[i] - b;
+                value[i] = value[i] * (a + d * d);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            value[i] = 1.0 / value[i];
+        }
+    }
+
+    template<int S> GENZ_INLINE
+    void cornerPeakS(int ndim, int n, const double z[],
+                     const double alpha[], const double upper[],
+                     double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        double total[chunk_size];
+        for (int start = 0; start < n; start += chunk_size) {
+            const int len = min(chunk_size, n - start);
+            double *v = &value[start];
+            for (int i = 0; i < len; i++) {
+                total[i] = 1.0;
+            }
+            for (int j = 0; j < dim; j++) {
+                const double *x = &z[j * n + start];
+                if (upper[j] == 0) {
+                    for (int i = 0; i < len; i++) {
+                        total[i] = total[i] + x[i];
+                    }
+                } else {
+                    const double a = alpha[j];
+                    for (int i = 0; i < len; i++) {
+                        total[i] = total[i] + a - x[i];
+                    }
+                }
+            }
+            // total^(dim + 1) by binary powering, the exponent is
+            // the same for all lanes.
+            for (int i = 0; i < len; i++) {
+                v[i] = 1.0;
+            }
+            for (unsigned e = dim + 1; e != 0; e >>= 1) {
+                if (e & 1) {
+                    for (int i = 0; i < len; i++) {
+                        v[i] *= total[i];
+                    }
+                }
+                if (e > 1) {
+                    for (int i = 0; i < len; i++) {
+                        total[i] *= total[i];
+                    }
+                }
+            }
+            for (int i = 0; i < len; i++) {
+                v[i] = 1.0 / v[i];
+            }
+        }
+    }
+
+    template<int S> GENZ_INLINE
+    void gaussianS(int ndim, int n, const double z[],
+                   const double alpha[], const double beta[],
+                   double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        for (int i = 0; i < n; i++) {
+            value[i] = 0.0;
+        }
+        for (int j = 0; j < dim; j++) {
+            const double *x = &z[j * n];
+            const double a = alpha[j];
+            const double b = beta[j];
+            for (int i = 0; i < n; i++) {
+                const double t = a * (x[i] - b);
+                value[i] = value[i] + t * t;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            value[i] = value[i] < 100.0 ? value[i] : 100.0;
+        }
+        for (int i = 0; i < n; i++) {
+            value[i] = exp(- value[i]);
+        }
+    }
+
+    template<int S> GENZ_INLINE
+    void c0FunctionS(int ndim, int n, const double z[],
+                     const double alpha[], const double beta[],
+                     double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        for (int i = 0; i < n; i++) {
+            value[i] = 0.0;
+        }
+        for (int j = 0; j < dim; j++) {
+            const double *x = &z[j * n];
+            const double a = alpha[j];
+            const double b = beta[j];
+            for (int i = 0; i < n; i++) {
+                value[i] = value[i] + a * fabs(x[i] - b);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            value[i] = exp(- value[i]);
+        }
+    }
+
+    template<int S> GENZ_INLINE
+    void discontinuousS(int ndim, int n, const double z[],
+                        const double alpha[], const double beta[],
+                        double value[])
+    {
+        const int dim = S > 0 ? S : ndim;
+        char out[chunk_size];
+        for (int start = 0; start < n; start += chunk_size) {
+            const int len = min(chunk_size, n - start);
+            double *v = &value[start];
+            for (int i = 0; i < len; i++) {
+                v[i] = 0.0;
+                out[i] = 0;
+            }
+            for (int j = 0; j < dim; j++) {
+                const double *x = &z[j * n + start];
+                const double a = alpha[j];
+                const double b = beta[j];
+                for (int i = 0; i < len; i++) {
+                    out[i] |= (b < x[i]);
+                    v[i] = v[i] + a * x[i];
+                }
+            }
+            for (int i = 0; i < len; i++) {
+                if (out[i]) {
+                    v[i] = 0.0;
+                } else {
+                    v[i] = exp(v[i]);
+                }
+            }
+        }
+    }
+}
+
+namespace GenzSIMD {
+    GENZ_SIMD_CLONES
+    void oscillatory(int ndim, int n, const double z[], const double w[],
+                     double c, double value[])
+    {
+        GENZ_DISPATCH(oscillatoryS, ndim, ndim, n, z, w, c, value);
+    }
+
+    GENZ_SIMD_CLONES
+    void productPeak(int ndim, int n, const double z[],
+                     const double inv[], const double beta[],
+                     double value[])
+    {
+        GENZ_DISPATCH(productPeakS, ndim, ndim, n, z, inv, beta, value);
+    }
+
+    GENZ_SIMD_CLONES
+    void cornerPeak(int ndim, int n, const double z[],
+                    const double alpha[], const double upper[],
+                    double value[])
+    {
+        GENZ_DISPATCH(cornerPeakS, ndim, ndim, n, z, alpha, upper, value);
+    }
+
+    GENZ_SIMD_CLONES
+    void gaussian(int ndim, int n, const double z[],
+                  const double alpha[], const double beta[],
+                  double value[])
+    {
+        GENZ_DISPATCH(gaussianS, ndim, ndim, n, z, alpha, beta, value);
+    }
+
+    GENZ_SIMD_CLONES
+    void c0Function(int ndim, int n, const double z[],
+                    const double alpha[], const double beta[],
+                    double value[])
+    {
+        GENZ_DISPATCH(c0FunctionS, ndim, ndim, n, z, alpha, beta, value);
+    }
+
+    GENZ_SIMD_CLONES
+    void discontinuous(int ndim, int n, const double z[],
+                       const double alpha[], const double beta[],
+                       double value[])
+    {
+        GENZ_DISPATCH(discontinuousS, ndim, ndim, n, z, alpha, beta, value);
+    }
+
+    const char * isa()
+    {
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) \
+    && defined(__linux__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            return "avx512f";
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            return "avx2";
+        }
+#endif
+        return "default";
+    }
+}
+
+GenzBinding& GenzBinding::operator=(const GenzBinding& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    indx = other.indx;
+    c = other.c;
+    allocate(other.ndim);
+    for (int j = 0; j < ndim; j++) {
+        a[j] = other.a[j];
+        b[j] = other.b[j];
+    }
+    return *this;
+}
+
+void GenzBinding::allocate(int dim)
+{
+    // a and b start at 64 byte boundaries
+    const size_t align = 64 / sizeof(double);
+    size_t stride = (dim + align - 1) / align * align;
+    ndim = dim;
+    storage.assign(2 * stride + align, 0.0);
+    uintptr_t p = reinterpret_cast<uintptr_t>(&storage[0]);
+    size_t skip = (64 - p % 64) % 64 / sizeof(double);
+    a = &storage[skip];
+    b = &storage[skip + stride];
+}
+
+void GenzBinding::bind(int indx, int ndim, const double alpha[],
+                       const double beta[])
+{
+    this->indx = indx;
+    allocate(ndim);
+    c = 0;
+    switch (indx) {
+    case 1:
+        c = 2.0 * M_PI * beta[0];
+        for (int j = 0; j < ndim; j++) {
+            a[j] = alpha[j];
+        }
+        break;
+    case 2:
+        for (int j = 0; j < ndim; j++) {
+            a[j] = 1.0 / (alpha[j] * alpha[j]);
+            b[j] = beta[j];
+        }
+        break;
+    case 3:
+        for (int j = 0; j < ndim; j++) {
+            a[j] = alpha[j];
+            b[j] = beta[j] < 0.5 ? 0.0 : 1.0;
+        }
+        break;
+    case 4:
+    case 5:
+    case 6:
+        for (int j = 0; j < ndim; j++) {
+            a[j] = alpha[j];
+            b[j] = beta[j];
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void GenzBinding::bindUnitWeights(int ndim, const double beta[])
+{
+    indx = 1;
+    allocate(ndim);
+    c = 2.0 * M_PI * beta[0];
+    for (int j = 0; j < ndim; j++) {
+        a[j] = 1.0;
+    }
+}
+
+void GenzBinding::evaluate(int n, const double z[], double value[]) const
+{
+    using namespace GenzSIMD;
+    switch (indx) {
+    case 1:
+        oscillatory(ndim, n, z, a, c, value);
+        break;
+    case 2:
+        productPeak(ndim, n, z, a, b, value);
+        break;
+    case 3:
+        cornerPeak(ndim, n, z, a, b, value);
+        break;
+    case 4:
+        gaussian(ndim, n, z, a, b, value);
+        break;
+    case 5:
+        c0Function(ndim, n, z, a, b, value);
+        break;
+    case 6:
+        discontinuous(ndim, n, z, a, b, value);
+        break;
+    default:
+        for (int i = 0; i < n; i++) {
+            value[i] = 0.0;
+        }
+    }
+}
+
+void genz_function_soa(int indx, int ndim, int n, const double z[],
+                       const double alpha[], const double beta[],
+                       double value[])
+{
+    GenzBinding genz(indx, ndim, alpha, beta);
+    genz.evaluate(n, z, value);
+}
@@ -0,0 +1,134 @@
+#pragma once
+#ifndef GENZ_SIMD_H
+#define GENZ_SIMD_H
+/**
+ * @file genz_simd.h
+ *
+ * @brief Genz test integrands over structure-of-arrays blocks of points.
+ *
+ * A block of n points in ndim dimensions is stored dimension-major,
+ * z[j * n + i] is the j-th coordinate of the i-th point, so that the
+ * loops run over points and are vectorized. The kernels are compiled
+ * for AVX-512, AVX2 and the base instruction set, and the best one is
+ * selected at run time.
+ */
+
+#include <vector>
+
+namespace GenzSIMD {
+    /**
+     * cos(c + sum_j w_j z_j)
+     * @param w weights
+     */
+    void oscillatory(int ndim, int n, const double z[], const double w[],
+                     double c, double value[]);
+    /**
+     * 1 / prod_j (inv_j + (z_j - beta_j)^2)
+     * @param inv alpha_j^{-2}
+     */
+    void productPeak(int ndim, int n, const double z[],
+                     const double inv[], const double beta[],
+                     double value[]);
+    /**
+     * (1 + sum_j t_j)^{-(ndim + 1)}, where t_j = z_j if upper_j is 0,
+     * otherwise t_j = alpha_j - z_j.
+     * @param upper 1 if beta_j >= 0.5, otherwise 0
+     */
+    void cornerPeak(int ndim, int n, const double z[],
+                    const double alpha[], const double upper[],
+                    double value[]);
+    /**
+     * exp(- min(sum_j (alpha_j (z_j - beta_j))^2, 100))
+     */
+    void gaussian(int ndim, int n, const double z[],
+                  const double alpha[], const double beta[],
+                  double value[]);
+    /**
+     * exp(- sum_j alpha_j |z_j - beta_j|)
+     */
+    void c0Function(int ndim, int n, const double z[],
+                    const double alpha[], const double beta[],
+                    double value[]);
+    /**
+     * 0 if z_j > beta_j for some j, otherwise exp(sum_j alpha_j z_j)
+     */
+    void discontinuous(int ndim, int n, const double z[],
+                       const double alpha[], const double beta[],
+                       double value[]);
+    /**
+     * name of the instruction set selected at run time.
+     */
+    const char * isa();
+}
+
+/**
+ * Parameters of a Genz function bound for repeated evaluation.
+ *
+ * bind() computes what depends only on alpha and beta once, and keeps
+ * it in two arrays of ndim doubles aligned to 64 bytes, so that
+ * evaluate() touches only the points.
+ */
+class GenzBinding {
+public:
+    GenzBinding() {
+        indx = 0;
+        ndim = 0;
+        c = 0;
+        a = NULL;
+        b = NULL;
+    }
+    /**
+     * @param indx genz function number, 1 ... 6, as genz_function
+     * @param ndim dimension
+     * @param alpha parameter
+     * @param beta parameter
+     */
+    GenzBinding(int indx, int ndim, const double alpha[],
+                const double beta[]) {
+        a = NULL;
+        b = NULL;
+        bind(indx, ndim, alpha, beta);
+    }
+    GenzBinding(const GenzBinding& other) {
+        a = NULL;
+        b = NULL;
+        *this = other;
+    }
+    GenzBinding& operator=(const GenzBinding& other);
+    void bind(int indx, int ndim, const double alpha[], const double beta[]);
+    /**
+     * the same as bind(), but the weights of Oscillatory are all 1
+     * as Oscillatory in Genz.hpp.
+     */
+    void bindUnitWeights(int ndim, const double beta[]);
+    /**
+     * values at n points in dimension-major layout,
+     * z[j * n + i] is the j-th coordinate of i-th point.
+     */
+    void evaluate(int n, const double z[], double value[]) const;
+    int getIndex() const {
+        return indx;
+    }
+    int getDimension() const {
+        return ndim;
+    }
+private:
+    int indx;
+    int ndim;
+    double c;
+    double *a;
+    double *b;
+    std::vector<double> storage;
+    void allocate(int ndim);
+};
+
+/**
+ * the same function as genz_function_block, but the points are given
+ * dimension-major, z[j * n + i] is the j-th coordinate of i-th point.
+ * Parameters are bound at every call, GenzBinding is for repeated calls.
+ */
+void genz_function_soa(int indx, int ndim, int n, const double z[],
+                       const double alpha[], const double beta[],
+                       double value[]);
+
+#endif // GENZ_SIMD_H
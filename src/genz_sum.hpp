@@ -0,0 +1,45 @@
+#pragma once
+#ifndef GENZ_SUM_HPP
+#define GENZ_SUM_HPP
+
+#include <inttypes.h>
+#include <vector>
+#include <algorithm>
+#include "kahan.hpp"
+#include "genz_simd.h"
+
+/**
+ * number of points passed to GenzBinding::evaluate at once
+ */
+const int genz_block_size = 256;
+
+/**
+ * add the values of genz function at next count points of digitalNet
+ * to sum. Points are evaluated genz_block_size points at a time
+ * in structure-of-arrays layout.
+ * @param sum Kahan or KahanLanes
+ * @param genz genz function and its parameters
+ */
+template<typename S, typename D>
+void genz_sum_points(S& sum, const GenzBinding& genz, D& digitalNet,
+                     uint64_t count)
+{
+    const int dim = genz.getDimension();
+    std::vector<double> points(genz_block_size * dim);
+    double values[genz_block_size];
+    for (uint64_t i = 0; i < count; i += genz_block_size) {
+        int n = static_cast<int>(
+            std::min<uint64_t>(genz_block_size, count - i));
+        for (int k = 0; k < n; k++) {
+            const double *tuple = digitalNet.getPoint();
+            for (int j = 0; j < dim; j++) {
+                points[j * n + k] = tuple[j];
+            }
+            digitalNet.nextPoint();
+        }
+        genz.evaluate(n, &points[0], values);
+        sum.add(values, n);
+    }
+}
+
+#endif // GENZ_SUM_HPP
@@ -0,0 +1,478 @@
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <cerrno>
+#include <getopt.h>
+#include <cstdlib>
+#include <string>
+#include <MCQMCIntegration/DigitalNet.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include "testpack.h"
+#include "genz_sum.hpp"
+#include "make_parameters.h"
+#include "GrayCodeNet.hpp"
+#include "parallel_sum.hpp"
+#include "thread_pool.hpp"
+#include "result_store.h"
+
+using namespace std;
+using namespace MCQMCIntegration;
+
+//#define DEBUG
+
+/*
+ * Sweep of testpack_digitalnet over digital nets, genz functions,
+ * s and m in one process.
+ * Parameters of genz functions are made once for each (genz_no, s),
+ * and a digital net is made once for each (net, s, m) and used for all
+ * genz functions. Nets are handed to a thread pool, larger first, and
+ * a line is printed when a cell is finished, so the order of lines
+ * depends on the timing of threads.
+ */
+namespace {
+    struct cmd_opt_t {
+        vector<int> dn_ids;
+        vector<int> genz_nos;
+        vector<int> s_dims;
+        uint32_t start_m;
+        uint32_t end_m;
+        uint32_t seed;
+        int rmse;
+        int original;
+        double difficulty;
+        int threads;
+        bool verbose;
+        string dbfile;
+    };
+
+    struct genz_param_t {
+        GenzBinding genz;
+        double expected;
+    };
+
+    typedef map<pair<int, int>, genz_param_t> param_map_t;
+
+    struct sweep_t {
+        const cmd_opt_t *opt;
+        const param_map_t *params;
+        ResultStore *store;
+        // guards store and cout
+        mutex out_mutex;
+        // DigitalNet reads tables of the library, it is not known
+        // to be thread safe.
+        mutex net_mutex;
+    };
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
+    void cmd_message(const string& pgm);
+    bool parse_range(const char *arg, vector<int>& values);
+    void sweep_net(sweep_t& sweep, int dn_id, int s, int m);
+    double integral(const GrayCodeNet& net, const genz_param_t& param,
+                    int count, const cmd_opt_t& opt);
+    ResultKey result_key(const cmd_opt_t& opt, int dn_id, int s, int m,
+                         int genz_no);
+    void print_line(int dn_id, int s, int m, int genz_no, double expected,
+                    double error);
+}
+
+int main(int argc, char *argv[]) {
+    cmd_opt_t opt;
+    if (!parse_opt(opt, argc, argv)) {
+        return -1;
+    }
+    ResultStore store;
+    if (!opt.dbfile.empty() && !store.open(opt.dbfile)) {
+        cout << "can't open database " << opt.dbfile << ": "
+             << store.errorMessage() << endl;
+        return -1;
+    }
+    param_map_t params;
+    for (size_t i = 0; i < opt.genz_nos.size(); i++) {
+        for (size_t j = 0; j < opt.s_dims.size(); j++) {
+            int genz_no = opt.genz_nos[i];
+            int s = opt.s_dims[j];
+            genz_param_t& param = params[make_pair(genz_no, s)];
+            vector<double> a(s, 0.0);
+            vector<double> b(s, 0.0);
+            vector<double> alpha(s, 0.0);
+            vector<double> beta(s, 0.0);
+            makeParameter(genz_no, s, opt.seed, opt.original,
+                          &a[0], &b[0], &alpha[0], &beta[0],
+                          opt.verbose, opt.difficulty);
+            param.expected = genz_integral(genz_no, s, &a[0], &b[0],
+                                           &alpha[0], &beta[0]);
+            param.genz.bind(genz_no, s, &alpha[0], &beta[0]);
+        }
+    }
+    cout << "#seed = " << opt.seed << endl;
+    cout << "#threads = " << opt.threads << endl;
+    if (opt.rmse > 0) {
+        cout << "#net, s, m, genz_no, expected, abs err, log2(RMSE["
+             << dec << opt.rmse << "])" << endl;
+    } else {
+        cout << "#net, s, m, genz_no, expected, abs err, log2(err)" << endl;
+    }
+    struct net_cell_t {
+        int dn_id;
+        int s;
+        int m;
+    };
+    vector<net_cell_t> cells;
+    for (size_t i = 0; i < opt.dn_ids.size(); i++) {
+        for (size_t j = 0; j < opt.s_dims.size(); j++) {
+            for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
+                net_cell_t c = {opt.dn_ids[i], opt.s_dims[j],
+                                static_cast<int>(m)};
+                cells.push_back(c);
+            }
+        }
+    }
+    // larger first, so that the last tasks are short
+    stable_sort(cells.begin(), cells.end(),
+                [](const net_cell_t& x, const net_cell_t& y) {
+                    return (static_cast<double>(x.s) * exp2(x.m))
+                        > (static_cast<double>(y.s) * exp2(y.m));
+                });
+    sweep_t sweep;
+    sweep.opt = &opt;
+    sweep.params = &params;
+    sweep.store = &store;
+    {
+        ThreadPool pool(opt.threads);
+        for (size_t i = 0; i < cells.size(); i++) {
+            net_cell_t c = cells[i];
+            pool.submit([&sweep, c]() {
+                    sweep_net(sweep, c.dn_id, c.s, c.m);
+                });
+        }
+        pool.wait();
+    }
+    if (!store.close()) {
+        store.reportError();
+        return -1;
+    }
+    return 0;
+}
+
+namespace {
+    /**
+     * integrate genz functions not in the database by the net.
+     */
+    void sweep_net(sweep_t& sweep, int dn_id, int s, int m)
+    {
+        const cmd_opt_t& opt = *sweep.opt;
+        vector<int> todo;
+        {
+            unique_lock<mutex> lock(sweep.out_mutex);
+            for (size_t i = 0; i < opt.genz_nos.size(); i++) {
+                int genz_no = opt.genz_nos[i];
+                ResultKey key = result_key(opt, dn_id, s, m, genz_no);
+                double expected;
+                double error;
+                if (sweep.store->find(key, &expected, &error)) {
+                    print_line(dn_id, s, m, genz_no, expected, error);
+                } else {
+                    todo.push_back(genz_no);
+                }
+            }
+        }
+        if (todo.empty()) {
+            return;
+        }
+        unique_ptr<GrayCodeNet> net;
+        {
+            unique_lock<mutex> lock(sweep.net_mutex);
+            DigitalNetID dnid = static_cast<DigitalNetID>(dn_id);
+            DigitalNet<uint64_t> dn(dnid, s, m);
+            net.reset(new GrayCodeNet(dn));
+        }
+        int count = 1 << m;
+        for (size_t i = 0; i < todo.size(); i++) {
+            int genz_no = todo[i];
+            const genz_param_t& param
+                = sweep.params->find(make_pair(genz_no, s))->second;
+            double error = integral(*net, param, count, opt);
+            unique_lock<mutex> lock(sweep.out_mutex);
+            ResultKey key = result_key(opt, dn_id, s, m, genz_no);
+            if (!sweep.store->add(key, param.expected, error)
+                || !sweep.store->flush()) {
+                sweep.store->reportError();
+            }
+            print_line(dn_id, s, m, genz_no, param.expected, error);
+        }
+    }
+
+    /**
+     * the same as testpack_digitalnet without digital shift, or with
+     * RMSE by shifts made from seed.
+     */
+    double integral(const GrayCodeNet& net, const genz_param_t& param,
+                    int count, const cmd_opt_t& opt)
+    {
+        const GenzBinding& genz = param.genz;
+        auto sum_range = [&genz](KahanLanes& sum, GrayCodeNet& cursor,
+                                 uint64_t n) {
+            genz_sum_points(sum, genz, cursor, n);
+        };
+        if (opt.rmse > 0) {
+            return parallel_rmse(net, count, opt.rmse, 1, opt.seed,
+                                 param.expected, sum_range);
+        }
+        GrayCodeNet cursor(net);
+        KahanLanes sum;
+        sum_range(sum, cursor, count);
+        return abs(param.expected - sum.get() / count);
+    }
+
+    ResultKey result_key(const cmd_opt_t& opt, int dn_id, int s, int m,
+                         int genz_no)
+    {
+        ResultKey key;
+        key.program = "genz_sweep";
+        key.net = getDigitalNetName(dn_id);
+        key.s = s;
+        key.m = m;
+        key.genz_no = genz_no;
+        key.seed = opt.seed;
+        key.shift = 0;
+        ostringstream params;
+        params << "original=" << opt.original
+               << " difficulty=" << opt.difficulty
+               << " rmse=" << opt.rmse;
+        key.params = params.str();
+        return key;
+    }
+
+    void print_line(int dn_id, int s, int m, int genz_no, double expected,
+                    double error)
+    {
+        cout << getDigitalNetName(dn_id) << "," << dec << s << "," << m
+             << "," << genz_no << "," << expected << "," << error << ","
+             << log2(error) << endl;
+    }
+
+    /**
+     * list of integers like 1,3,5-8,16-64:8
+     */
+    bool parse_range(const char *arg, vector<int>& values)
+    {
+        values.clear();
+        const char *p = arg;
+        for (;;) {
+            char *end;
+            errno = 0;
+            long first = strtol(p, &end, 10);
+            if (errno || end == p || first < 0) {
+                return false;
+            }
+            long last = first;
+            long step = 1;
+            p = end;
+            if (*p == '-') {
+                p++;
+                last = strtol(p, &end, 10);
+                if (errno || end == p || last < first) {
+                    return false;
+                }
+                p = end;
+                if (*p == ':') {
+                    p++;
+                    step = strtol(p, &end, 10);
+                    if (errno || end == p || step <= 0) {
+                        return false;
+                    }
+                    p = end;
+                }
+            }
+            for (long v = first; v <= last; v += step) {
+                values.push_back(static_cast<int>(v));
+            }
+            if (*p == '\0') {
+                return true;
+            }
+            if (*p != ',') {
+                return false;
+            }
+            p++;
+        }
+    }
+
+    void cmd_message(const string& pgm)
+    {
+        cout << pgm << " -d digitalnet_ids -g genz_nos -s s_dims"
+             << " -m start_m -M end_m [-S seed] [-r rmse] [-o] [-D difficulty]"
+             << " [-j threads] [-b database] [-v]" << endl;
+        cout << "\tdigitalnet_ids, genz_nos and s_dims are lists like"
+             << " 1,3,5-8,16-64:8" << endl;
+        cout << "\t--digitalnet-id, -d\tdigital nets" << endl;
+        cout << "\t--genz-no, -g\t\tgenz functions, default 1-6" << endl;
+        cout << "\t--s-dim, -s\t\tdimensions" << endl;
+        cout << "\t--threads, -j\t\tnumber of threads" << endl;
+        cout << "\t--db, -b\t\tsqlite3 database to store results,"
+             << " cells" << endl
+             << "\t\t\t\talready in it are not computed again" << endl;
+    }
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
+    {
+        int c;
+        bool error = false;
+        string pgm = argv[0];
+        static struct option longopts[] = {
+            {"s-dim", required_argument, NULL, 's'},
+            {"start-m", required_argument, NULL, 'm'},
+            {"end-m", required_argument, NULL, 'M'},
+            {"seed", required_argument, NULL, 'S'},
+            {"genz-no", required_argument, NULL, 'g'},
+            {"digitalnet-id", required_argument, NULL, 'd'},
+            {"rmse", optional_argument, NULL, 'r'},
+            {"orignal", optional_argument, NULL, 'o'},
+            {"difficulty", required_argument, NULL, 'D'},
+            {"threads", required_argument, NULL, 'j'},
+            {"db", required_argument, NULL, 'b'},
+            {"verbose", no_argument, NULL, 'v'},
+            {NULL, 0, NULL, 0}};
+        opt.start_m = 0;
+        opt.end_m = 0;
+        opt.seed = 1;
+        opt.rmse = 0;
+        opt.original = 0;
+        opt.difficulty = -1;
+        opt.threads = 1;
+        opt.verbose = false;
+        parse_range("1-6", opt.genz_nos);
+        errno = 0;
+        for (;;) {
+            c = getopt_long(argc, argv, "s:m:M:S:g:d:r:o::D:j:b:v",
+                            longopts, NULL);
+            if (error) {
+                break;
+            }
+            if (c == -1) {
+                break;
+            }
+            switch (c) {
+            case 's':
+                if (!parse_range(optarg, opt.s_dims)) {
+                    cout << "s_dims should be a list of numbers" << endl;
+                    error = true;
+                }
+                break;
+            case 'm':
+                opt.start_m = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "start_m should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'M':
+                opt.end_m = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "end_m should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'S':
+                opt.seed = strtoul(optarg, NULL, 10);
+                if (errno) {
+                    cout << "seed should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'g':
+                if (!parse_range(optarg, opt.genz_nos)) {
+                    cout << "genz_nos should be a list of numbers" << endl;
+                    error = true;
+                }
+                break;
+            case 'd':
+                if (!parse_range(optarg, opt.dn_ids)) {
+                    cout << "digitalnet_ids should be a list of numbers"
+                         << endl;
+                    error = true;
+                }
+                break;
+            case 'r':
+                if (optarg == NULL) {
+                    opt.rmse = 100;
+                } else {
+                    opt.rmse = strtoul(optarg, NULL, 10);
+                }
+                if (errno) {
+                    cout << "rmse should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'o':
+                if (optarg == NULL) {
+                    opt.original = 1;
+                } else if (optarg[0] == 'x') {
+                    opt.original = -1;
+                } else {
+                    opt.original = strtol(optarg, NULL, 10);
+                    if (errno) {
+                        cout << "original shoud be one of {-1, 0, 1}." << endl;
+                        error = true;
+                    }
+                }
+                break;
+            case 'D':
+                opt.difficulty = strtod(optarg, NULL);
+                if (errno) {
+                    cout << "difficulty should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'b':
+                opt.dbfile = optarg;
+                break;
+            case 'v':
+                opt.verbose = true;
+                break;
+            case '?':
+            default:
+                error = true;
+                break;
+            }
+        }
+        if (opt.dn_ids.empty() || opt.s_dims.empty()) {
+            cout << "digitalnet_ids and s_dims are required" << endl;
+            error = true;
+        }
+        for (size_t i = 0; i < opt.genz_nos.size(); i++) {
+            if (opt.genz_nos[i] < 1 || opt.genz_nos[i] > 6) {
+                cout << "genz_no shoule be 1 <= genz_no <= 6" << endl;
+                error = true;
+                break;
+            }
+        }
+        for (size_t i = 0; i < opt.dn_ids.size(); i++) {
+            if (opt.dn_ids[i] >= 100) {
+                cout << "random nets are not supported" << endl;
+                error = true;
+                break;
+            }
+        }
+        if (opt.end_m < opt.start_m) {
+            opt.end_m = opt.start_m;
+        }
+        if (error) {
+            cmd_message(pgm);
+            return false;
+        }
+        return true;
+    }
+}
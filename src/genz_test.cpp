@@ -5,15 +5,34 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
-#include <memory>
 
 #define DEBUG
 #include "Genz.hpp"
+#include "workspace.hpp"
 
 using namespace std;
 using namespace MCQMCIntegration;
 using namespace GenzNS;
 
+namespace {
+    template<typename F>
+    void run(int digital_net_id, int s, int start_m, int stop_m,
+             double alpha[], double beta[])
+    {
+        F func;
+        cout << "#genz_name = " << func.name() << endl;
+        cout << "#m, abs err, log2(err)" << endl;
+        for (int m = start_m; m <= stop_m; m++) {
+            DigitalNetID dnid = static_cast<DigitalNetID>(digital_net_id);
+            DigitalNet<uint64_t> dn(dnid, s, m);
+            int count = 1 << m;
+            double err = integral(func, dn, count, s, alpha, beta);
+            double l = log2(err);
+            cout << dec << m << "," << err << "," << l << endl;
+        }
+    }
+}
+
 int main(int argc, char * argv[])
 {
     if (argc < 7) {
@@ -43,38 +62,36 @@ int main(int argc, char * argv[])
     cout << "#seed = " << dec << seed << endl;
     mt19937_64 mt(seed);
     uniform_real_distribution<double> unif01(0.0, 1.0);
-    double alpha[s];
-    double beta[s];
+    Workspace work;
+    double *alpha = work.alloc(s);
+    double *beta = work.alloc(s);
     for (int i = 0; i < s; i++) {
         alpha[i] = unif01(mt);
         beta[i] = unif01(mt);
     }
-    //int genz_size = 6;
-    shared_ptr<GenzFunction> genz[] = {
-        shared_ptr<GenzFunction>(new Oscillatory()),
-        shared_ptr<GenzFunction>(new ProductPeak()),
-        shared_ptr<GenzFunction>(new CornerPeak()),
-        shared_ptr<GenzFunction>(new Gaussian()),
-        shared_ptr<GenzFunction>(new C0Function()),
-        shared_ptr<GenzFunction>(new Discontinuous())
-    };
-    if (genz_id < 1 || genz_id > 6) {
+    // the type of function is fixed here
+    switch (genz_id) {
+    case 1:
+        run<Oscillatory>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    case 2:
+        run<ProductPeak>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    case 3:
+        run<CornerPeak>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    case 4:
+        run<Gaussian>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    case 5:
+        run<C0Function>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    case 6:
+        run<Discontinuous>(digital_net_id, s, start_m, stop_m, alpha, beta);
+        break;
+    default:
         cout << "genz_id should be 1 ... 6" << endl;
         return -1;
     }
-    GenzFunction& func = *genz[genz_id-1];
-    cout << "#genz_name = " << func.name() << endl;
-    cout << "#m, abs err, log2(err)" << endl;
-    for (int m = start_m; m <= stop_m; m++) {
-        DigitalNetID dnid = static_cast<DigitalNetID>(digital_net_id);
-        //cout << "dnid = " << dnid << endl;
-        DigitalNet<uint64_t> dn(dnid, s, m);
-        int count = 1 << m;
-#if defined(DEBUG)
-#endif
-        double err = integral(func, dn, count, s, alpha, beta);
-        double l = log2(err);
-        cout << dec << m << "," << err << "," << l << endl;
-    }
     return 0;
 }
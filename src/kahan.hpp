@@ -19,6 +19,8 @@
  * @see https://en.wikipedia.org/wiki/Kahan_summation_algorithm
  */
 
+#include <cmath>
+
 class Kahan {
 public:
     Kahan() {
@@ -35,6 +37,11 @@ public:
         c = (t - sum) - y;
         sum = t;
     }
+    void add(const double x[], int n) {
+        for (int i = 0; i < n; i++) {
+            add(x[i]);
+        }
+    }
     double get() {
         return sum;
     }
@@ -43,4 +50,106 @@ private:
     double sum;
 };
 
+/**
+ * Neumaier summation in independent lanes.
+ *
+ * i-th value added goes to lane i % lanes, and each lane keeps its own
+ * sum and compensation, so that add() of an array has no dependency
+ * between consecutive values and is vectorized. get() adds the lanes
+ * with compensation. The result depends only on the sequence of values
+ * added, and is at least as accurate as Kahan.
+ */
+class KahanLanes {
+public:
+    enum { lanes = 8, state_size = 2 * lanes };
+    KahanLanes() {
+        clear();
+    }
+    void clear() {
+        for (int k = 0; k < lanes; k++) {
+            sum[k] = 0.0;
+            c[k] = 0.0;
+        }
+        next = 0;
+    }
+    void add(const double x) {
+        addLane(next, x);
+        next = (next + 1) % lanes;
+    }
+    void add(const double x[], int n) {
+        int i = 0;
+        for (; next != 0 && i < n; i++) {
+            add(x[i]);
+        }
+        for (; i + lanes <= n; i += lanes) {
+            for (int k = 0; k < lanes; k++) {
+                addLane(k, x[i + k]);
+            }
+        }
+        for (; i < n; i++) {
+            add(x[i]);
+        }
+    }
+    /**
+     * add partial sum of other, for example the sum of another thread.
+     */
+    void merge(const KahanLanes& other) {
+        for (int k = 0; k < lanes; k++) {
+            addLane(k, other.sum[k]);
+            c[k] += other.c[k];
+        }
+    }
+    /**
+     * copy sums and compensations to state[state_size], for example to
+     * send a partial sum to another process.
+     */
+    void save(double state[]) const {
+        for (int k = 0; k < lanes; k++) {
+            state[k] = sum[k];
+            state[lanes + k] = c[k];
+        }
+    }
+    /**
+     * restore the partial sum saved by save(). The next value added
+     * goes to lane 0.
+     */
+    void load(const double state[]) {
+        for (int k = 0; k < lanes; k++) {
+            sum[k] = state[k];
+            c[k] = state[lanes + k];
+        }
+        next = 0;
+    }
+    double get() const {
+        double total = 0.0;
+        double comp = 0.0;
+        for (int k = 0; k < lanes; k++) {
+            const double t = total + sum[k];
+            if (std::fabs(total) >= std::fabs(sum[k])) {
+                comp += (total - t) + sum[k];
+            } else {
+                comp += (sum[k] - t) + total;
+            }
+            total = t;
+        }
+        for (int k = 0; k < lanes; k++) {
+            comp += c[k];
+        }
+        return total + comp;
+    }
+private:
+    double sum[lanes];
+    double c[lanes];
+    int next;
+
+    void addLane(int k, const double x) {
+        const double t = sum[k] + x;
+        const bool sum_big = std::fabs(sum[k]) >= std::fabs(x);
+        const double big = sum_big ? sum[k] : x;
+        const double small = sum_big ? x : sum[k];
+        c[k] += (big - t) + small;
+        sum[k] = t;
+    }
+};
+
 #endif // KAHAN_HPP
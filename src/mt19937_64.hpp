@@ -63,6 +63,7 @@
 */
 
 #include <inttypes.h>
+#include <stddef.h>
 
 class mt19937_64 {
 public:
@@ -134,6 +135,53 @@ public:
         return getUint64() >> 32;
     }
 
+    /*
+     * fills out[0], ..., out[n-1] with the numbers of n calls of
+     * getUint64(). The tempering runs over the rest of the state block
+     * at once, in a loop without branches which can be vectorized.
+     */
+    void fill(uint64_t out[], size_t n) {
+        while (n > 0) {
+            if (index >= NN) {
+                genall();
+            }
+            size_t c = NN - index;
+            if (c > n) {
+                c = n;
+            }
+            const uint64_t *p = array + index;
+            for (size_t i = 0; i < c; i++) {
+                out[i] = temper(p[i]);
+            }
+            index += c;
+            out += c;
+            n -= c;
+        }
+    }
+
+    /*
+     * fills out[0], ..., out[n-1] with the numbers of n calls of
+     * getDouble01().
+     */
+    void fillDouble01(double out[], size_t n) {
+        while (n > 0) {
+            if (index >= NN) {
+                genall();
+            }
+            size_t c = NN - index;
+            if (c > n) {
+                c = n;
+            }
+            const uint64_t *p = array + index;
+            for (size_t i = 0; i < c; i++) {
+                out[i] = (temper(p[i]) >> 11) * (1.0/9007199254740992.0);
+            }
+            index += c;
+            out += c;
+            n -= c;
+        }
+    }
+
     /* generates a random number on [0,1)-real-interval */
     double getDouble01() {
         return (getUint64() >> 11) * (1.0/9007199254740992.0);
@@ -159,22 +207,29 @@ private:
     /* Least significant 31 bits */
     uint64_t LM;
 
+    /*
+     * The members are copied to locals, and mag01[x & 1] is replaced by
+     * a mask of the lowest bit, so that the loops can be vectorized.
+     */
     void genall() {
         int i;
         uint64_t x;
-        const uint64_t mag01[2]={UINT64_C(0), MATRIX_A};
+        uint64_t *st = array;
+        const uint64_t a = MATRIX_A;
+        const uint64_t um = UM;
+        const uint64_t lm = LM;
         /* if init_genrand64() has not been called, */
         /* a default initial seed is used     */
         for (i=0;i<NN-MM;i++) {
-            x = (array[i]&UM)|(array[i+1]&LM);
-            array[i] = array[i+MM] ^ (x>>1) ^ mag01[(int)(x&UINT64_C(1))];
+            x = (st[i]&um)|(st[i+1]&lm);
+            st[i] = st[i+MM] ^ (x>>1) ^ ((UINT64_C(0) - (x&1)) & a);
         }
         for (;i<NN-1;i++) {
-            x = (array[i]&UM)|(array[i+1]&LM);
-            array[i] = array[i+(MM-NN)] ^ (x>>1) ^ mag01[(int)(x&UINT64_C(1))];
+            x = (st[i]&um)|(st[i+1]&lm);
+            st[i] = st[i+(MM-NN)] ^ (x>>1) ^ ((UINT64_C(0) - (x&1)) & a);
         }
-        x = (array[NN-1]&UM)|(array[0]&LM);
-        array[NN-1] = array[MM-1] ^ (x>>1) ^ mag01[(int)(x&UINT64_C(1))];
+        x = (st[NN-1]&um)|(st[0]&lm);
+        st[NN-1] = st[MM-1] ^ (x>>1) ^ ((UINT64_C(0) - (x&1)) & a);
         index = 0;
     }
 
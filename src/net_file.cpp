@@ -0,0 +1,243 @@
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <MCQMCIntegration/DigitalNet.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include "net_file.h"
+
+using namespace std;
+
+namespace {
+    const char net_file_magic[8] = {'D', 'N', 'E', 'T', 'B', 'I', 'N', 0};
+    const uint64_t net_file_byte_order = UINT64_C(0x0102030405060708);
+
+    static_assert(sizeof(NetFileHeader) == 64,
+                  "NetFileHeader should be 64 bytes");
+}
+
+uint64_t net_file_checksum(const uint64_t data[], size_t size)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    return hash;
+}
+
+bool is_net_file(const string& path)
+{
+    ifstream ifs(path.c_str(), ios::binary);
+    char magic[sizeof(net_file_magic)];
+    if (!ifs.read(magic, sizeof(magic))) {
+        return false;
+    }
+    return memcmp(magic, net_file_magic, sizeof(magic)) == 0;
+}
+
+bool write_net_file(const string& path, int s, int m,
+                    const uint64_t mat[], uint32_t flags, double wafom,
+                    int tvalue)
+{
+    NetFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, net_file_magic, sizeof(header.magic));
+    header.byte_order = net_file_byte_order;
+    header.version = NET_FILE_VERSION;
+    header.header_size = sizeof(header);
+    header.bit_width = 64;
+    header.s = s;
+    header.m = m;
+    header.flags = flags;
+    header.wafom = (flags & NET_FILE_WAFOM) ? wafom : 0;
+    header.tvalue = (flags & NET_FILE_TVALUE) ? tvalue : 0;
+    size_t size = static_cast<size_t>(s) * m;
+    header.checksum = net_file_checksum(mat, size);
+    ofstream ofs(path.c_str(), ios::binary | ios::trunc);
+    ofs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    ofs.write(reinterpret_cast<const char *>(mat), size * sizeof(uint64_t));
+    ofs.close();
+    return !ofs.fail();
+}
+
+bool read_net_file(const string& path, int *s, int *m,
+                   vector<uint64_t>& mat, string& msg)
+{
+    if (is_net_file(path)) {
+        NetFile file;
+        if (!file.open(path)) {
+            msg = file.errorMessage();
+            return false;
+        }
+        *s = file.getS();
+        *m = file.getM();
+        mat.assign(file.getBase(),
+                   file.getBase() + static_cast<size_t>(*s) * *m);
+        return true;
+    }
+    ifstream dnstream(path.c_str());
+    if (!dnstream) {
+        msg = "can't open " + path;
+        return false;
+    }
+    MCQMCIntegration::DigitalNet<uint64_t> dn(dnstream);
+    *s = dn.getS();
+    *m = dn.getM();
+    if (*s < 1 || *m < 1 || *m > 63) {
+        msg = "can't read digital net from " + path;
+        return false;
+    }
+    mat.resize(static_cast<size_t>(*s) * *m);
+    for (int i = 0; i < *m; i++) {
+        for (int j = 0; j < *s; j++) {
+            mat[i * *s + j] = dn.getBase(i, j);
+        }
+    }
+    return true;
+}
+
+bool list_net_files(const string& path, vector<string>& files, string& msg)
+{
+    files.clear();
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        msg = "can't find " + path;
+        return false;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path.c_str());
+        if (dir == NULL) {
+            msg = "can't open directory " + path;
+            return false;
+        }
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (entry->d_name[0] == '.') {
+                continue;
+            }
+            string name = path + "/" + entry->d_name;
+            if (stat(name.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+                files.push_back(name);
+            }
+        }
+        closedir(dir);
+        sort(files.begin(), files.end());
+        return true;
+    }
+    ifstream manifest(path.c_str());
+    if (!manifest) {
+        msg = "can't open manifest " + path;
+        return false;
+    }
+    string dir;
+    size_t slash = path.rfind('/');
+    if (slash != string::npos) {
+        dir = path.substr(0, slash + 1);
+    }
+    string line;
+    while (getline(manifest, line)) {
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == string::npos || line[first] == '#') {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t\r");
+        string name = line.substr(first, last - first + 1);
+        if (name[0] != '/') {
+            name = dir + name;
+        }
+        files.push_back(name);
+    }
+    return true;
+}
+
+NetFile::NetFile()
+{
+    map = NULL;
+    map_size = 0;
+    header = NULL;
+    base = NULL;
+}
+
+NetFile::~NetFile()
+{
+    close();
+}
+
+bool NetFile::open(const string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return fail("can't open " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return fail("can't stat " + path);
+    }
+    if (static_cast<size_t>(st.st_size) < sizeof(NetFileHeader)) {
+        ::close(fd);
+        return fail(path + " is too short");
+    }
+    map_size = st.st_size;
+    map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping is kept after the descriptor is closed
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        map = NULL;
+        return fail("can't map " + path);
+    }
+    header = static_cast<const NetFileHeader *>(map);
+    if (memcmp(header->magic, net_file_magic, sizeof(header->magic)) != 0) {
+        return fail(path + " is not a binary digital net file");
+    }
+    if (header->byte_order != net_file_byte_order) {
+        return fail(path + " was made on a machine of other byte order");
+    }
+    if (header->version != NET_FILE_VERSION) {
+        return fail(path + " is of unknown version");
+    }
+    if (header->bit_width != 64) {
+        return fail(path + " has unsupported bit width");
+    }
+    if (header->header_size < sizeof(NetFileHeader)
+        || header->header_size % sizeof(uint64_t) != 0) {
+        return fail(path + " has broken header");
+    }
+    if (header->s < 1 || header->m < 1 || header->m > 63) {
+        return fail(path + " has wrong s or m");
+    }
+    size_t size = static_cast<size_t>(header->s) * header->m;
+    if (map_size != header->header_size + size * sizeof(uint64_t)) {
+        return fail(path + " has wrong size");
+    }
+    base = reinterpret_cast<const uint64_t *>(
+        static_cast<const char *>(map) + header->header_size);
+    if (net_file_checksum(base, size) != header->checksum) {
+        return fail(path + " has wrong checksum");
+    }
+    return true;
+}
+
+void NetFile::close()
+{
+    if (map != NULL) {
+        munmap(map, map_size);
+    }
+    map = NULL;
+    map_size = 0;
+    header = NULL;
+    base = NULL;
+}
+
+bool NetFile::fail(const string& msg)
+{
+    close();
+    message = msg;
+    return false;
+}
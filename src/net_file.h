@@ -0,0 +1,156 @@
+#pragma once
+#ifndef NET_FILE_H
+#define NET_FILE_H
+/**
+ * @file net_file.h
+ *
+ * @brief digital nets in a binary file mapped to memory.
+ *
+ * The file is a NetFileHeader followed by s * m 64-bit unsigned
+ * integers, where the i * s + j th integer is the i-th row of the
+ * generating matrix of j-th coordinate, the same order as
+ * DigitalNet::getBase(i, j). All numbers are in the byte order of the
+ * machine which made the file, and a file of the other byte order is
+ * rejected. The file is mapped read only, so that processes reading
+ * the same file share its pages.
+ * convert_net makes the file from the text format in README.
+ */
+
+#include <inttypes.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * header of binary digital net file, 64 bytes
+ */
+struct NetFileHeader {
+    /** "DNETBIN" and NUL */
+    char magic[8];
+    /** 0x0102030405060708 */
+    uint64_t byte_order;
+    /** version of format, 1 */
+    uint32_t version;
+    /** offset of the matrix from the top of file */
+    uint32_t header_size;
+    /** bits of an element of the matrix, 64 */
+    uint32_t bit_width;
+    uint32_t s;
+    uint32_t m;
+    /** NET_FILE_WAFOM and NET_FILE_TVALUE */
+    uint32_t flags;
+    /** WAFOM of the net, valid if flags has NET_FILE_WAFOM */
+    double wafom;
+    /** t-value of the net, valid if flags has NET_FILE_TVALUE */
+    int32_t tvalue;
+    uint32_t reserved;
+    /** net_file_checksum() of the matrix */
+    uint64_t checksum;
+};
+
+const uint32_t NET_FILE_VERSION = 1;
+const uint32_t NET_FILE_WAFOM = 1;
+const uint32_t NET_FILE_TVALUE = 2;
+
+/**
+ * FNV-1a hash of 64-bit words.
+ */
+uint64_t net_file_checksum(const uint64_t data[], size_t size);
+
+/**
+ * true if path is a binary digital net file, that is
+ * it can be opened and starts with the magic.
+ */
+bool is_net_file(const std::string& path);
+
+/**
+ * write binary digital net file.
+ * @param path file name
+ * @param s dimension of R
+ * @param m dimension of F2
+ * @param mat s * m rows, mat[i * s + j] is i-th row of j-th coordinate
+ * @param flags NET_FILE_WAFOM and/or NET_FILE_TVALUE, or 0
+ * @param wafom WAFOM of the net
+ * @param tvalue t-value of the net
+ * @return false if failed
+ */
+bool write_net_file(const std::string& path, int s, int m,
+                    const uint64_t mat[], uint32_t flags, double wafom,
+                    int tvalue);
+
+/**
+ * read digital net file of binary format or text format in README.
+ * @param path file name
+ * @param s dimension of R
+ * @param m dimension of F2
+ * @param mat s * m rows, mat[i * s + j] is i-th row of j-th coordinate
+ * @param msg error message if failed
+ * @return false if failed
+ */
+bool read_net_file(const std::string& path, int *s, int *m,
+                   std::vector<uint64_t>& mat, std::string& msg);
+
+/**
+ * list digital net files of a directory or a manifest.
+ * Files in a directory are sorted by name, and names starting with '.'
+ * are skipped. A manifest is a text file of a file name per line,
+ * empty lines and lines starting with '#' are skipped, and relative
+ * names are relative to the directory of the manifest.
+ * @param path directory or manifest
+ * @param files file names
+ * @param msg error message if failed
+ * @return false if failed
+ */
+bool list_net_files(const std::string& path, std::vector<std::string>& files,
+                    std::string& msg);
+
+/**
+ * binary digital net file mapped read only.
+ */
+class NetFile {
+public:
+    NetFile();
+    ~NetFile();
+    /**
+     * map the file and check header, size and checksum.
+     * @param path file name
+     * @return false if failed, see errorMessage()
+     */
+    bool open(const std::string& path);
+    void close();
+    int getS() const {
+        return header->s;
+    }
+    int getM() const {
+        return header->m;
+    }
+    /**
+     * s * m rows, getBase()[i * s + j] is i-th row of j-th coordinate.
+     */
+    const uint64_t * getBase() const {
+        return base;
+    }
+    const NetFileHeader& getHeader() const {
+        return *header;
+    }
+    bool hasWafom() const {
+        return (header->flags & NET_FILE_WAFOM) != 0;
+    }
+    bool hasTValue() const {
+        return (header->flags & NET_FILE_TVALUE) != 0;
+    }
+    const std::string& errorMessage() const {
+        return message;
+    }
+private:
+    NetFile(const NetFile&);
+    NetFile& operator=(const NetFile&);
+    void *map;
+    size_t map_size;
+    const NetFileHeader *header;
+    const uint64_t *base;
+    std::string message;
+    bool fail(const std::string& msg);
+};
+
+#endif // NET_FILE_H
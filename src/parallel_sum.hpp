@@ -0,0 +1,243 @@
+#pragma once
+#ifndef PARALLEL_SUM_HPP
+#define PARALLEL_SUM_HPP
+
+#include <inttypes.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include "kahan.hpp"
+#include "GrayCodeNet.hpp"
+
+/**
+ * Sum of a function over points [start, start + count) of a digital net
+ * using threads.
+ *
+ * The range is split into threads contiguous sub-ranges, each thread
+ * sums its sub-range with its own copy of the cursor, and the partial
+ * sums are added in the order of the sub-ranges. The result depends on
+ * the number of threads, but not on the timing of threads.
+ *
+ * @param net cursor, it is copied for each thread and not moved.
+ * @param start index of the first point
+ * @param count number of points
+ * @param threads number of threads
+ * @param sum_range sum_range(KahanLanes& sum, GrayCodeNet& cursor,
+ * uint64_t n)
+ * should add the values of the function at next n points of cursor to sum.
+ * @param total the partial sums are merged to it.
+ */
+template<typename F>
+void parallel_sum_lanes(const MCQMCIntegration::GrayCodeNet& net,
+                        uint64_t start, uint64_t count, int threads,
+                        F sum_range, KahanLanes& total)
+{
+    using namespace MCQMCIntegration;
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (count < static_cast<uint64_t>(threads)) {
+        threads = 1;
+    }
+    std::vector<KahanLanes> partial(threads);
+    std::vector<std::thread> workers;
+    uint64_t chunk = count / threads;
+    for (int k = 0; k < threads; k++) {
+        uint64_t first = start + chunk * k;
+        uint64_t n = chunk;
+        if (k == threads - 1) {
+            n = count - chunk * k;
+        }
+        workers.push_back(std::thread([&net, &partial, &sum_range,
+                                       k, first, n]() {
+                    GrayCodeNet cursor(net);
+                    cursor.setIndex(first);
+                    sum_range(partial[k], cursor, n);
+                }));
+    }
+    for (int k = 0; k < threads; k++) {
+        workers[k].join();
+        total.merge(partial[k]);
+    }
+}
+
+/**
+ * the same as parallel_sum_lanes(), but returns the sum.
+ * @return sum of the function values
+ */
+template<typename F>
+double parallel_sum(const MCQMCIntegration::GrayCodeNet& net,
+                    uint64_t start, uint64_t count, int threads,
+                    F sum_range)
+{
+    KahanLanes total;
+    parallel_sum_lanes(net, start, count, threads, sum_range, total);
+    return total.get();
+}
+
+/**
+ * seed of the digital shift of r-th replica, made from seed by
+ * splitmix64 so that the shifts of replicas are independent.
+ */
+inline uint64_t replica_seed(uint64_t seed, uint64_t r)
+{
+    uint64_t z = seed + (r + 1) * UINT64_C(0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/**
+ * Root mean squared error of replicas digitally shifted independently.
+ *
+ * Replicas are handed to threads one by one. r-th replica uses the
+ * shift made from replica_seed(seed, r) and squared errors are summed
+ * in the order of replicas, so that the result does not depend on
+ * the number of threads.
+ *
+ * @param net digital net, it is copied for each replica.
+ * @param count number of points
+ * @param replicas number of replicas
+ * @param threads number of threads
+ * @param seed seed of digital shifts
+ * @param expected expected value of the integral
+ * @param sum_range see parallel_sum()
+ * @return RMSE
+ */
+template<typename F>
+double parallel_rmse(const MCQMCIntegration::GrayCodeNet& net,
+                     uint64_t count, int replicas, int threads,
+                     uint64_t seed, double expected, F sum_range)
+{
+    using namespace MCQMCIntegration;
+    if (threads < 1) {
+        threads = 1;
+    }
+    std::vector<double> square(replicas);
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        for (;;) {
+            int r = next++;
+            if (r >= replicas) {
+                break;
+            }
+            GrayCodeNet cursor(net);
+            cursor.setSeed(replica_seed(seed, r));
+            cursor.setDigitalShift(true);
+            cursor.pointInitialize();
+            KahanLanes sum;
+            sum_range(sum, cursor, count);
+            double er = expected - sum.get() / count;
+            square[r] = er * er;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int k = 0; k < threads; k++) {
+        workers.push_back(std::thread(work));
+    }
+    for (int k = 0; k < threads; k++) {
+        workers[k].join();
+    }
+    Kahan esum;
+    for (int r = 0; r < replicas; r++) {
+        esum.add(square[r]);
+    }
+    return sqrt(esum.get() / replicas);
+}
+
+/**
+ * Sums of a function over the first 2^m points of a digital net for
+ * m = start_m, ..., end_m, computed by one pass over 2^end_m points.
+ * The first 2^m points in gray code order are the points of the net made
+ * from the first m rows of the generating matrices.
+ *
+ * @param net digital net, it is copied and not moved.
+ * @param start_m smallest m
+ * @param end_m largest m
+ * @param threads number of threads, points from 2^(m-1) to 2^m are
+ * summed by parallel_sum_lanes() if threads > 1.
+ * @param sum_range see parallel_sum()
+ * @param sum output, sum[m - start_m] is the sum over 2^m points.
+ */
+template<typename F>
+void nested_sum(const MCQMCIntegration::GrayCodeNet& net,
+                int start_m, int end_m, int threads, F sum_range,
+                double sum[])
+{
+    using namespace MCQMCIntegration;
+    GrayCodeNet cursor(net);
+    cursor.setIndex(0);
+    KahanLanes total;
+    uint64_t done = 0;
+    for (int m = start_m; m <= end_m; m++) {
+        uint64_t next = UINT64_C(1) << m;
+        if (threads <= 1) {
+            sum_range(total, cursor, next - done);
+        } else {
+            parallel_sum_lanes(net, done, next - done, threads, sum_range,
+                               total);
+        }
+        done = next;
+        sum[m - start_m] = total.get();
+    }
+}
+
+/**
+ * RMSE of replicas for m = start_m, ..., end_m by one pass over
+ * 2^end_m points of each replica. Replicas and their shifts are the same
+ * as parallel_rmse(), so the results are the same as parallel_rmse()
+ * for each m.
+ *
+ * @param rmse output, rmse[m - start_m] is the RMSE of 2^m points.
+ */
+template<typename F>
+void nested_rmse(const MCQMCIntegration::GrayCodeNet& net,
+                 int start_m, int end_m, int replicas, int threads,
+                 uint64_t seed, double expected, F sum_range, double rmse[])
+{
+    using namespace MCQMCIntegration;
+    if (threads < 1) {
+        threads = 1;
+    }
+    int levels = end_m - start_m + 1;
+    std::vector<double> square(static_cast<size_t>(replicas) * levels);
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        for (;;) {
+            int r = next++;
+            if (r >= replicas) {
+                break;
+            }
+            GrayCodeNet cursor(net);
+            cursor.setSeed(replica_seed(seed, r));
+            cursor.setDigitalShift(true);
+            cursor.pointInitialize();
+            KahanLanes sum;
+            uint64_t done = 0;
+            for (int k = 0; k < levels; k++) {
+                uint64_t count = UINT64_C(1) << (start_m + k);
+                sum_range(sum, cursor, count - done);
+                done = count;
+                double er = expected - sum.get() / count;
+                square[static_cast<size_t>(r) * levels + k] = er * er;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int k = 0; k < threads; k++) {
+        workers.push_back(std::thread(work));
+    }
+    for (int k = 0; k < threads; k++) {
+        workers[k].join();
+    }
+    for (int k = 0; k < levels; k++) {
+        Kahan esum;
+        for (int r = 0; r < replicas; r++) {
+            esum.add(square[static_cast<size_t>(r) * levels + k]);
+        }
+        rmse[k] = sqrt(esum.get() / replicas);
+    }
+}
+
+#endif // PARALLEL_SUM_HPP
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef POINT_STREAM_H
+#define POINT_STREAM_H
+/**
+ * @file point_stream.h
+ *
+ * @brief binary stream of points written by simpleout.
+ *
+ * Without chunks, the stream is count * s values and nothing else,
+ * value k * s + j is j-th coordinate of k-th point.
+ * With chunks, the stream is a PointStreamHeader followed by chunks,
+ * and each chunk is a PointChunkHeader followed by points * s values.
+ * All chunks but the last have PointStreamHeader::chunk points.
+ * All numbers are in the byte order of the writer, which is shown by
+ * byte_order.
+ */
+
+#include <inttypes.h>
+
+/**
+ * header of chunked point stream, 48 bytes
+ */
+struct PointStreamHeader {
+    /** "DNETPTS" and NUL */
+    char magic[8];
+    /** 0x0102030405060708 */
+    uint64_t byte_order;
+    /** version of format, 1 */
+    uint32_t version;
+    /** offset of the first chunk from the top of stream */
+    uint32_t header_size;
+    /** POINT_STREAM_UINT64 or POINT_STREAM_DOUBLE */
+    uint32_t format;
+    uint32_t s;
+    /** number of points in the stream */
+    uint64_t count;
+    /** number of points in a chunk */
+    uint64_t chunk;
+};
+
+/**
+ * header of a chunk, 16 bytes
+ */
+struct PointChunkHeader {
+    /** index of the first point of the chunk */
+    uint64_t first;
+    /** number of points of the chunk */
+    uint64_t points;
+};
+
+const uint32_t POINT_STREAM_VERSION = 1;
+/** 64-bit integers, the point in [0, 1)^s is value / 2^64 */
+const uint32_t POINT_STREAM_UINT64 = 1;
+/** the same doubles as getPoint() */
+const uint32_t POINT_STREAM_DOUBLE = 2;
+
+#endif // POINT_STREAM_H
@@ -0,0 +1,207 @@
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <sqlite3.h>
+#include "result_store.h"
+
+using namespace std;
+
+namespace {
+    // rows and seconds of one transaction
+    const int batch_rows = 64;
+    const long batch_seconds = 10;
+
+    const char *create_sql =
+        "CREATE TABLE IF NOT EXISTS result ("
+        " program TEXT NOT NULL,"
+        " net TEXT NOT NULL,"
+        " s INTEGER NOT NULL,"
+        " m INTEGER NOT NULL,"
+        " genz_no INTEGER NOT NULL,"
+        " seed INTEGER NOT NULL,"
+        " shift INTEGER NOT NULL,"
+        " params TEXT NOT NULL,"
+        " expected REAL,"
+        " error REAL,"
+        " PRIMARY KEY (program, net, s, m, genz_no, seed, shift, params))";
+
+    const char *select_sql =
+        "SELECT expected, error FROM result WHERE"
+        " program = ?1 AND net = ?2 AND s = ?3 AND m = ?4 AND genz_no = ?5"
+        " AND seed = ?6 AND shift = ?7 AND params = ?8";
+
+    const char *insert_sql =
+        "INSERT OR REPLACE INTO result"
+        " (program, net, s, m, genz_no, seed, shift, params, expected, error)"
+        " VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10)";
+}
+
+ResultStore::ResultStore()
+{
+    db = NULL;
+    select_stmt = NULL;
+    insert_stmt = NULL;
+    pending = 0;
+    begin_time = 0;
+    reported = false;
+}
+
+ResultStore::~ResultStore()
+{
+    close();
+}
+
+bool ResultStore::open(const string& path)
+{
+    close();
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        fail();
+        close();
+        return false;
+    }
+    // processes of a sweep may share the database
+    sqlite3_busy_timeout(db, 60000);
+    if (!exec(create_sql)
+        || sqlite3_prepare_v2(db, select_sql, -1, &select_stmt, NULL)
+        != SQLITE_OK
+        || sqlite3_prepare_v2(db, insert_sql, -1, &insert_stmt, NULL)
+        != SQLITE_OK) {
+        fail();
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool ResultStore::find(const ResultKey& key, double *expected, double *error)
+{
+    if (db == NULL) {
+        return false;
+    }
+    sqlite3_reset(select_stmt);
+    bindKey(select_stmt, key);
+    int rc = sqlite3_step(select_stmt);
+    if (rc != SQLITE_ROW) {
+        if (rc != SQLITE_DONE) {
+            fail();
+        }
+        return false;
+    }
+    *expected = sqlite3_column_double(select_stmt, 0);
+    if (sqlite3_column_type(select_stmt, 1) == SQLITE_NULL) {
+        *error = NAN;
+    } else {
+        *error = sqlite3_column_double(select_stmt, 1);
+    }
+    sqlite3_reset(select_stmt);
+    return true;
+}
+
+bool ResultStore::add(const ResultKey& key, double expected, double error)
+{
+    if (db == NULL) {
+        return true;
+    }
+    // no transaction, or sqlite rolled it back after an error
+    if (sqlite3_get_autocommit(db)) {
+        pending = 0;
+        if (!exec("BEGIN")) {
+            return false;
+        }
+        begin_time = static_cast<long>(time(NULL));
+    }
+    sqlite3_reset(insert_stmt);
+    bindKey(insert_stmt, key);
+    sqlite3_bind_double(insert_stmt, 9, expected);
+    if (std::isnan(error)) {
+        sqlite3_bind_null(insert_stmt, 10);
+    } else {
+        sqlite3_bind_double(insert_stmt, 10, error);
+    }
+    int rc = sqlite3_step(insert_stmt);
+    sqlite3_reset(insert_stmt);
+    if (rc != SQLITE_DONE) {
+        return fail();
+    }
+    pending++;
+    if (pending >= batch_rows
+        || static_cast<long>(time(NULL)) - begin_time >= batch_seconds) {
+        return flush();
+    }
+    return true;
+}
+
+bool ResultStore::flush()
+{
+    if (db == NULL || sqlite3_get_autocommit(db)) {
+        pending = 0;
+        return true;
+    }
+    if (!exec("COMMIT")) {
+        // the transaction is still open unless sqlite rolled it back,
+        // and the next flush() tries to commit it again
+        return false;
+    }
+    pending = 0;
+    return true;
+}
+
+bool ResultStore::close()
+{
+    if (db == NULL) {
+        return true;
+    }
+    bool ok = flush();
+    if (!ok && !sqlite3_get_autocommit(db)) {
+        string commit_message = message;
+        sqlite3_exec(db, "ROLLBACK", NULL, NULL, NULL);
+        message = commit_message;
+    }
+    pending = 0;
+    sqlite3_finalize(select_stmt);
+    sqlite3_finalize(insert_stmt);
+    select_stmt = NULL;
+    insert_stmt = NULL;
+    sqlite3_close(db);
+    db = NULL;
+    return ok;
+}
+
+void ResultStore::reportError()
+{
+    if (reported) {
+        return;
+    }
+    reported = true;
+    cerr << "can't store results: " << message << endl;
+}
+
+bool ResultStore::exec(const char *sql)
+{
+    if (sqlite3_exec(db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+        return fail();
+    }
+    return true;
+}
+
+void ResultStore::bindKey(sqlite3_stmt *stmt, const ResultKey& key)
+{
+    sqlite3_bind_text(stmt, 1, key.program.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, key.net.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, key.s);
+    sqlite3_bind_int(stmt, 4, key.m);
+    sqlite3_bind_int(stmt, 5, key.genz_no);
+    sqlite3_bind_int64(stmt, 6, key.seed);
+    sqlite3_bind_int(stmt, 7, key.shift);
+    sqlite3_bind_text(stmt, 8, key.params.c_str(), -1, SQLITE_TRANSIENT);
+}
+
+bool ResultStore::fail()
+{
+    if (db != NULL) {
+        message = sqlite3_errmsg(db);
+    } else {
+        message = "can't open database";
+    }
+    return false;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#ifndef RESULT_STORE_H
+#define RESULT_STORE_H
+/**
+ * @file result_store.h
+ *
+ * @brief results of sweeps stored in a sqlite3 database.
+ *
+ * One row is kept for each configuration, and a program can skip
+ * configurations already in the database, so that a sweep which
+ * stopped halfway computes only the missing ones when it is run again.
+ * Rows are inserted in transactions of some rows.
+ */
+
+#include <inttypes.h>
+#include <cstddef>
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+/**
+ * key of a row
+ */
+struct ResultKey {
+    /** name of the program */
+    std::string program;
+    /** digital net name or file name */
+    std::string net;
+    int s;
+    int m;
+    /** genz_no, or sai_no for saipack */
+    int genz_no;
+    uint32_t seed;
+    /** digital shift id, 0 means no shift */
+    int shift;
+    /** other options which change the result */
+    std::string params;
+};
+
+class ResultStore {
+public:
+    ResultStore();
+    ~ResultStore();
+    /**
+     * open database, the table is created if not exists.
+     * @param path file name of database
+     * @return false if failed, see errorMessage()
+     */
+    bool open(const std::string& path);
+    bool isOpen() const {
+        return db != NULL;
+    }
+    /**
+     * search row of key.
+     * @param key key
+     * @param expected output, expected value of the integral
+     * @param error output, error
+     * @return true if found
+     */
+    bool find(const ResultKey& key, double *expected, double *error);
+    /**
+     * insert or replace row, it is committed when batch rows are added,
+     * some seconds passed, or flush() is called.
+     * @param key key
+     * @param expected expected value of the integral
+     * @param error error, NaN is stored as NULL
+     * @return false if failed, see errorMessage(). Without a database
+     * nothing is stored and true is returned.
+     */
+    bool add(const ResultKey& key, double expected, double error);
+    /**
+     * commit rows added. Programs call it when a configuration is
+     * finished, so that rows are not left uncommitted while the next
+     * one is computed. If the commit fails, the rows are kept in the
+     * transaction and the next flush() tries again.
+     * @return false if failed, see errorMessage()
+     */
+    bool flush();
+    /**
+     * commit rows added and close database.
+     * @return false if the commit failed, see errorMessage()
+     */
+    bool close();
+    const std::string& errorMessage() const {
+        return message;
+    }
+    /**
+     * print errorMessage() to cerr, only the first time called, so that
+     * a program can call it after every failure.
+     */
+    void reportError();
+private:
+    ResultStore(const ResultStore&);
+    ResultStore& operator=(const ResultStore&);
+    sqlite3 *db;
+    sqlite3_stmt *select_stmt;
+    sqlite3_stmt *insert_stmt;
+    int pending;
+    long begin_time;
+    bool reported;
+    std::string message;
+    bool exec(const char *sql);
+    void bindKey(sqlite3_stmt *stmt, const ResultKey& key);
+    bool fail();
+};
+
+#endif // RESULT_STORE_H
@@ -5,11 +5,21 @@
 #include <string>
 #include <random>
 #include <cmath>
+#include <inttypes.h>
+#include <vector>
+#include <algorithm>
 
 class Saipack {
 public:
     virtual ~Saipack() {};
     virtual double operator()(const double x[]) = 0;
+    /**
+     * values of the function at n points.
+     * @param n number of points
+     * @param x points, x[i * dim + j] is j-th coordinate of i-th point
+     * @param value output, n values
+     */
+    virtual void evaluate(int n, const double x[], double value[]) = 0;
     virtual void setParam(int dim, double ap[], double bp[]) = 0;
     virtual double expected(int dim, double ap[], double bp[]) = 0;
     virtual const std::string getName() = 0;
@@ -17,26 +27,69 @@ public:
                                double a[], double b[], bool verbose) = 0;
 };
 
-static inline void printParameter(int dim, double a[], double b[]) {
-    std::cout << "# a = {";
-    for (int i = 0; i < dim; i++) {
-        std::cout << a[i] << ",";
+/**
+ * call f.evaluateS<S>() with the dimension S fixed at compile time
+ * for the dimensions used in sweeps, S = 0 is the generic kernel.
+ */
+template<typename F>
+static inline void saipack_dispatch(F& f, int s, int n, const double x[],
+                                    double value[])
+{
+    switch (s) {
+    case 4: f.template evaluateS<4>(n, x, value); break;
+    case 8: f.template evaluateS<8>(n, x, value); break;
+    case 16: f.template evaluateS<16>(n, x, value); break;
+    case 32: f.template evaluateS<32>(n, x, value); break;
+    case 64: f.template evaluateS<64>(n, x, value); break;
+    default: f.template evaluateS<0>(n, x, value); break;
     }
-    std::cout << "}" << std::endl;
-    std::cout << "# b = {";
-    for (int i = 0; i < dim; i++) {
-        std::cout << b[i] << ",";
+}
+
+/**
+ * number of points passed to Saipack::evaluate at once
+ */
+const int saipack_block_size = 256;
+
+/**
+ * add the values of func at next count points of digitalNet to sum.
+ * @param sum Kahan or KahanLanes
+ * @param func Saipack, or a derived class to avoid virtual calls
+ */
+template<typename S, typename F, typename D>
+void saipack_sum_points(S& sum, F& func, D& digitalNet,
+                        uint64_t count, int dim)
+{
+    std::vector<double> points(saipack_block_size * dim);
+    double values[saipack_block_size];
+    for (uint64_t i = 0; i < count; i += saipack_block_size) {
+        int n = static_cast<int>(
+            std::min<uint64_t>(saipack_block_size, count - i));
+        for (int k = 0; k < n; k++) {
+            const double *tuple = digitalNet.getPoint();
+            std::copy(tuple, tuple + dim, &points[k * dim]);
+            digitalNet.nextPoint();
+        }
+        func.evaluate(n, &points[0], values);
+        sum.add(values, n);
     }
-    std::cout << "}" << std::endl;
 }
 
-class AddSai : Saipack {
+/**
+ * common part of the functions below.
+ *
+ * Derived class gives evaluateS<S>(), and operator() and evaluate()
+ * call it without virtual call, so that the loops over points of
+ * saipack_sum_points() instantiated for a derived class are inlined.
+ */
+template<typename Derived>
+class SaipackBase : public Saipack {
 public:
-    AddSai() {
+    SaipackBase() {
+        s = 0;
         a = NULL;
         b = NULL;
     }
-    ~AddSai() {
+    ~SaipackBase() {
         if (a != NULL) {
             delete[] a;
             delete[] b;
@@ -56,11 +109,54 @@ public:
         }
     }
     double operator()(const double x[]) {
-        double sum = 0;
-        for (int i = 0; i < s; i++) {
-            sum += x[i] * x[i] + a[i] * x[i] + b[i];
+        double value;
+        derived().template evaluateS<0>(1, x, &value);
+        return value;
+    }
+    void evaluate(int n, const double x[], double value[]) {
+        saipack_dispatch(derived(), s, n, x, value);
+    }
+protected:
+    int s;
+    double * a;
+    double * b;
+private:
+    SaipackBase(const SaipackBase&);
+    SaipackBase& operator=(const SaipackBase&);
+    Derived& derived() {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+static inline void printParameter(int dim, double a[], double b[]) {
+    std::cout << "# a = {";
+    for (int i = 0; i < dim; i++) {
+        std::cout << a[i] << ",";
+    }
+    std::cout << "}" << std::endl;
+    std::cout << "# b = {";
+    for (int i = 0; i < dim; i++) {
+        std::cout << b[i] << ",";
+    }
+    std::cout << "}" << std::endl;
+}
+
+class AddSai final : public SaipackBase<AddSai> {
+public:
+    /**
+     * evaluate() for dimension S, S = 0 means s.
+     */
+    template<int S>
+    void evaluateS(int n, const double points[], double value[]) {
+        const int dim = S > 0 ? S : s;
+        for (int k = 0; k < n; k++) {
+            const double *x = &points[k * dim];
+            double sum = 0;
+            for (int i = 0; i < dim; i++) {
+                sum += x[i] * x[i] + a[i] * x[i] + b[i];
+            }
+            value[k] = sum;
         }
-        return sum;
     }
     double expected(int dim, double ap[], double bp[]) {
         double sum = 0;
@@ -97,45 +193,25 @@ public:
     const std::string getName() {
         return std::string("AddSai");
     }
-private:
-    int s;
-    double * a;
-    double * b;
 };
 
-class MulSai : Saipack {
+class MulSai final : public SaipackBase<MulSai> {
 public:
-    MulSai() {
-        a = NULL;
-        b = NULL;
-    }
-
-    ~MulSai() {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-    }
-    void setParam(int dim, double ap[], double bp[]) {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-        s = dim;
-        a = new double[dim];
-        b = new double[dim];
-        for (int i = 0; i < dim; i++) {
-            a[i] = ap[i];
-            b[i] = bp[i];
-        }
-    }
-    double operator()(const double x[]) {
-        double prod = 1.0;
-        for (int i = 0; i < s; i++) {
-            prod *= x[i] * x[i] * x[i]
-                + a[i] * x[i] * x[i] + b[i];
+    /**
+     * evaluate() for dimension S, S = 0 means s.
+     */
+    template<int S>
+    void evaluateS(int n, const double points[], double value[]) {
+        const int dim = S > 0 ? S : s;
+        for (int k = 0; k < n; k++) {
+            const double *x = &points[k * dim];
+            double prod = 1.0;
+            for (int i = 0; i < dim; i++) {
+                prod *= x[i] * x[i] * x[i]
+                    + a[i] * x[i] * x[i] + b[i];
+            }
+            value[k] = prod;
         }
-        return prod;
     }
     double expected(int dim, double ap[], double bp[]) {
         double prod = 1.0;
@@ -172,45 +248,24 @@ public:
     const std::string getName() {
         return std::string("MulSai");
     }
-
-private:
-    int s;
-    double * a;
-    double * b;
 };
 
-class SinSai : Saipack {
+class SinSai final : public SaipackBase<SinSai> {
 public:
-    SinSai() {
-        a = NULL;
-        b = NULL;
-    }
-
-    ~SinSai() {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-    }
-    void setParam(int dim, double ap[], double bp[]) {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-        s = dim;
-        a = new double[dim];
-        b = new double[dim];
-        for (int i = 0; i < dim; i++) {
-            a[i] = ap[i];
-            b[i] = bp[i];
-        }
-    }
-    double operator()(const double x[]) {
-        double prod = 1.0;
-        for (int i = 0; i < s; i++) {
-            prod *= sin(a[i] * x[i] + 2 * M_PI * b[i]);
+    /**
+     * evaluate() for dimension S, S = 0 means s.
+     */
+    template<int S>
+    void evaluateS(int n, const double points[], double value[]) {
+        const int dim = S > 0 ? S : s;
+        for (int k = 0; k < n; k++) {
+            const double *x = &points[k * dim];
+            double prod = 1.0;
+            for (int i = 0; i < dim; i++) {
+                prod *= sin(a[i] * x[i] + 2 * M_PI * b[i]);
+            }
+            value[k] = 1 + prod;
         }
-        return 1 + prod;
     }
     double expected(int dim, double ap[], double bp[]) {
         double prod = 1.0;
@@ -256,11 +311,6 @@ public:
     const std::string getName() {
         return std::string("SinSai");
     }
-
-private:
-    int s;
-    double * a;
-    double * b;
 };
 
 /**
@@ -272,42 +322,26 @@ private:
  * b_i > 1.0 山数がへっていく
  * b_i >= 5 谷か山
  */
-class PolSai : Saipack {
+class PolSai final : public SaipackBase<PolSai> {
 public:
-    PolSai() {
-        a = NULL;
-        b = NULL;
-    }
-
-    ~PolSai() {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-    }
-    void setParam(int dim, double ap[], double bp[]) {
-        if (a != NULL) {
-            delete[] a;
-            delete[] b;
-        }
-        s = dim;
-        a = new double[dim];
-        b = new double[dim];
-        for (int i = 0; i < dim; i++) {
-            a[i] = ap[i];
-            b[i] = bp[i];
-        }
-    }
-    double operator()(const double x[]) {
-        double prod = 1.0;
-        for (int i = 0; i < s; i++) {
-            prod *= a[i];
-            prod *= (x[i] + 1) * (x[i] - 2);
-            for (int j = 0; j < 4; j++) {
-                prod *= (x[i] - 0.2 * b[i] * (j + 1));
+    /**
+     * evaluate() for dimension S, S = 0 means s.
+     */
+    template<int S>
+    void evaluateS(int n, const double points[], double value[]) {
+        const int dim = S > 0 ? S : s;
+        for (int k = 0; k < n; k++) {
+            const double *x = &points[k * dim];
+            double prod = 1.0;
+            for (int i = 0; i < dim; i++) {
+                prod *= a[i];
+                prod *= (x[i] + 1) * (x[i] - 2);
+                for (int j = 0; j < 4; j++) {
+                    prod *= (x[i] - 0.2 * b[i] * (j + 1));
+                }
             }
+            value[k] = 1 + prod;
         }
-        return 1 + prod;
     }
 
     double expected(int dim, double ap[], double bp[]) {
@@ -360,11 +394,6 @@ public:
     const std::string getName() {
         return std::string("PolSai");
     }
-
-private:
-    int s;
-    double * a;
-    double * b;
 };
 
 #endif // SAIPACK_HPP
@@ -8,10 +8,15 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
 #include "saipack.hpp"
 #include "kahan.hpp"
 #include "RandomNet.hpp"
-#include <memory>
+#include "GrayCodeNet.hpp"
+#include "parallel_sum.hpp"
+#include "result_store.h"
+#include "net_file.h"
+#include "workspace.hpp"
 #include <random>
 
 
@@ -30,38 +35,40 @@ namespace {
         int dn_id;
         int rmse;
         int parameter;
+        int threads;
         bool verbose;
         string dnfile;
+        string dbfile;
     };
-#if 1
-    shared_ptr<Saipack> functions[] = {
-        shared_ptr<Saipack>(reinterpret_cast<Saipack *>(new AddSai())),
-        shared_ptr<Saipack>(reinterpret_cast<Saipack *>(new MulSai())),
-        shared_ptr<Saipack>(reinterpret_cast<Saipack *>(new SinSai())),
-        shared_ptr<Saipack>(reinterpret_cast<Saipack *>(new PolSai()))
-    };
-#else
-    Saipack functions[] = {
-        AddSai(),
-        MulSai(),
-        SinSai(),
-        PolSai()
-    };
-#endif
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
     void cmd_message(const string& pgm);
-    template<typename D>
-    double integral(Saipack& sai, D& digitalNet, int count,
+    template<typename F>
+    int run_sai(cmd_opt_t& opt);
+    template<typename F, typename D>
+    double integral(F& sai, D& digitalNet, int count,
                     double expected, int rmse,
                     bool verbose);
-    int file_sai(cmd_opt_t& opt, Saipack& sai, double expected);
-    int random_sai(cmd_opt_t& opt, Saipack& sai, double expected);
+    template<typename F>
+    double integral_parallel(F& sai, GrayCodeNet& net, int count,
+                             double expected, int rmse, bool verbose,
+                             int threads, uint64_t seed);
+    template<typename F>
+    int file_sai(cmd_opt_t& opt, F& sai, double expected);
+    template<typename F, typename D>
+    int file_sai_net(cmd_opt_t& opt, ResultStore& store, F& sai, D& dn,
+                     double expected);
+    template<typename F>
+    int random_sai(cmd_opt_t& opt, F& sai, double expected);
 //    template<typename D>
 //    void loop_integral(D& digitalNet, cmd_opt_t& opt,
 //                       int s, int start_m, int end_m);
     void print_header(cmd_opt_t& opt, const string& test_name,
                       const string& dn_name,
                       double expected);
+    bool open_store(ResultStore& store, const cmd_opt_t& opt);
+    int close_store(ResultStore& store);
+    ResultKey result_key(const cmd_opt_t& opt, const string& net, int s,
+                         int m);
 }
 
 int main(int argc, char *argv[]) {
@@ -72,46 +79,87 @@ int main(int argc, char *argv[]) {
     if (!parse_opt(opt, argc, argv)) {
         return -1;
     }
-    double a[opt.s_dim];
-    double b[opt.s_dim];
-    for (size_t i = 0; i < opt.s_dim; i++) {
-        a[i] = 0;
-        b[i] = 0;
+    // the type of function is fixed here, and the loops over points
+    // are instantiated for each function.
+    switch (opt.sai_no) {
+    case 0:
+        return run_sai<AddSai>(opt);
+    case 1:
+        return run_sai<MulSai>(opt);
+    case 2:
+        return run_sai<SinSai>(opt);
+    case 3:
+        return run_sai<PolSai>(opt);
+    default:
+        cout << "sai_no should be 0 ... 3" << endl;
+        return -1;
     }
+}
+
+namespace {
+    /**
+     * run all the computations for function F.
+     */
+    template<typename F>
+    int run_sai(cmd_opt_t& opt)
+    {
+        Workspace work;
+        double *a = work.alloc(opt.s_dim);
+        double *b = work.alloc(opt.s_dim);
 #if defined(DEBUG)
-    cout << "main step 2" << endl;
+        cout << "main step 2" << endl;
 #endif
-    Saipack& func = *functions[opt.sai_no];
-    std::mt19937_64 mt(opt.seed);
-    func.makeParameter(opt.parameter, opt.s_dim, mt, a, b, opt.verbose);
-    func.setParam(opt.s_dim, a, b);
-    double expected = func.expected(opt.s_dim, a, b);
+        F func;
+        std::mt19937_64 mt(opt.seed);
+        func.makeParameter(opt.parameter, opt.s_dim, mt, a, b, opt.verbose);
+        func.setParam(opt.s_dim, a, b);
+        double expected = func.expected(opt.s_dim, a, b);
 #if defined(DEBUG)
-    cout << "main step 3" << endl;
+        cout << "main step 3" << endl;
 #endif
-    if (opt.dn_id < 0) {
-        return file_sai(opt, func, expected);
-    }
-    if (opt.dn_id >= 100) {
-        return random_sai(opt, func, expected);
-    }
+        if (opt.dn_id < 0) {
+            return file_sai(opt, func, expected);
+        }
+        if (opt.dn_id >= 100) {
+            return random_sai(opt, func, expected);
+        }
 #if defined(DEBUG)
-    cout << "main step 4" << endl;
+        cout << "main step 4" << endl;
 #endif
-    DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
-    print_header(opt, func.getName(), getDigitalNetName(opt.dn_id),
-                 expected);
-    for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
-        DigitalNet<uint64_t> dn(dnid, opt.s_dim, m);
-        int count = 1 << m;
-        double error = integral(func, dn, count,
-                                expected, opt.rmse, opt.verbose);
-        cout << dec << m << "," << error << "," << log2(error) << endl;
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
+        DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
+        print_header(opt, func.getName(), getDigitalNetName(opt.dn_id),
+                     expected);
+        for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
+            ResultKey key = result_key(opt, getDigitalNetName(opt.dn_id),
+                                       opt.s_dim, m);
+            double stored;
+            double error;
+            if (store.find(key, &stored, &error)) {
+                cout << dec << m << "," << error << "," << log2(error) << endl;
+                continue;
+            }
+            DigitalNet<uint64_t> dn(dnid, opt.s_dim, m);
+            int count = 1 << m;
+            if (opt.threads > 1 || opt.rmse > 0) {
+                GrayCodeNet gc(dn);
+                error = integral_parallel(func, gc, count, expected, opt.rmse,
+                                          opt.verbose, opt.threads, opt.seed);
+            } else {
+                error = integral(func, dn, count,
+                                 expected, opt.rmse, opt.verbose);
+            }
+            if (!store.add(key, expected, error) || !store.flush()) {
+                store.reportError();
+            }
+            cout << dec << m << "," << error << "," << log2(error) << endl;
+        }
+        return close_store(store);
     }
-    return 0;
-}
 
-namespace {
     void print_header(cmd_opt_t& opt, const string& test_name,
                       const string& dn_name,
                       double expected)
@@ -126,54 +174,169 @@ namespace {
     cout << "#expected = " << expected << endl;
     }
 
-    int file_sai(cmd_opt_t& opt, Saipack& func, double expected)
+    template<typename F>
+    int file_sai(cmd_opt_t& opt, F& func, double expected)
     {
+        if (is_net_file(opt.dnfile)) {
+            NetFile file;
+            if (!file.open(opt.dnfile)) {
+                cout << file.errorMessage() << endl;
+                return -1;
+            }
+            ResultStore store;
+            if (!open_store(store, opt)) {
+                return -1;
+            }
+            GrayCodeNet dn(file.getS(), file.getM(), file.getBase());
+            dn.pointInitialize();
+            if (file_sai_net(opt, store, func, dn, expected) != 0) {
+                return -1;
+            }
+            return close_store(store);
+        }
         ifstream dnstream(opt.dnfile);
         if (!dnstream) {
             cout << "can't open digital_net_file" << endl;
             return -1;
         }
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
         DigitalNet<uint64_t> dn(dnstream);
         dn.pointInitialize();
 #if defined(DEBUG) && 0
         dn.showStatus(cout);
 #endif
-        if (dn.getS() != opt.s_dim) {
+        if (file_sai_net(opt, store, func, dn, expected) != 0) {
+            return -1;
+        }
+        return close_store(store);
+    }
+
+    /**
+     * the rest of file_sai() for digital net from text file or
+     * binary file.
+     */
+    template<typename F, typename D>
+    int file_sai_net(cmd_opt_t& opt, ResultStore& store, F& func, D& dn,
+                     double expected)
+    {
+        if (static_cast<uint32_t>(dn.getS()) != opt.s_dim) {
             cout << "s_dim != dn.getS()" << endl;
             return -1;
         }
         int m = dn.getM();
         print_header(opt, func.getName(), opt.dnfile, expected);
         cout << "# m = " << dec << m << endl;
+        ResultKey key = result_key(opt, opt.dnfile, dn.getS(), m);
+        double stored;
+        double error;
+        if (store.find(key, &stored, &error)) {
+            cout << dec << m << "," << error << "," << log2(error) << endl;
+            return 0;
+        }
         int count = 1 << m;
-        double error = integral(func, dn, count,
-                                expected, opt.rmse, opt.verbose);
+        if (opt.threads > 1 || opt.rmse > 0) {
+            GrayCodeNet gc(dn);
+            error = integral_parallel(func, gc, count, expected, opt.rmse,
+                                      opt.verbose, opt.threads, opt.seed);
+        } else {
+            error = integral(func, dn, count,
+                             expected, opt.rmse, opt.verbose);
+        }
+        if (!store.add(key, expected, error) || !store.flush()) {
+            store.reportError();
+        }
         cout << dec << m << "," << error << "," << log2(error) << endl;
         return 0;
     }
 
-    int random_sai(cmd_opt_t& opt, Saipack& func, double expected)
+    template<typename F>
+    int random_sai(cmd_opt_t& opt, F& func, double expected)
     {
         int s = opt.s_dim;
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
         RandomNet dn(s, 100);
         dn.pointInitialize();
         print_header(opt, func.getName(), "Random", expected);
         int mask = 64;
         dn.setMask(mask);
         for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
+            ResultKey key = result_key(opt, "Random", s, m);
+            double stored;
+            double error;
+            if (store.find(key, &stored, &error)) {
+                cout << dec << m << "," << error << "," << log2(error) << endl;
+                continue;
+            }
             int count = 1 << m;
-            double error = integral(func, dn, count,
-                                    expected, opt.rmse,
-                                    opt.verbose);
+            error = integral(func, dn, count,
+                             expected, opt.rmse,
+                             opt.verbose);
+            if (!store.add(key, expected, error) || !store.flush()) {
+                store.reportError();
+            }
             cout << dec << m << "," << error << "," << log2(error) << endl;
         }
-        return 0;
+        return close_store(store);
     }
 
     void cmd_message(const string& pgm)
     {
         cout << pgm << " -s s_dim -m start_m -M end_m -S seed -n sai_no"
-             << " [-d digitalnet_id] [-p] [-v] [digitalnet_file]" << endl;
+             << " [-d digitalnet_id] [-p] [-v] [-r rmse] [-j threads]"
+             << " [-b database] [digitalnet_file]" << endl;
+    }
+
+    /**
+     * open the result database if it is specified.
+     */
+    bool open_store(ResultStore& store, const cmd_opt_t& opt)
+    {
+        if (opt.dbfile.empty()) {
+            return true;
+        }
+        if (!store.open(opt.dbfile)) {
+            cout << "can't open database " << opt.dbfile << ": "
+                 << store.errorMessage() << endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * commit the results and close the database.
+     * @return 0, or -1 if the results couldn't be stored
+     */
+    int close_store(ResultStore& store)
+    {
+        if (!store.close()) {
+            store.reportError();
+            return -1;
+        }
+        return 0;
+    }
+
+    ResultKey result_key(const cmd_opt_t& opt, const string& net, int s,
+                         int m)
+    {
+        ResultKey key;
+        key.program = "saipack_digitalnet";
+        key.net = net;
+        key.s = s;
+        key.m = m;
+        key.genz_no = opt.sai_no;
+        key.seed = opt.seed;
+        key.shift = 0;
+        ostringstream params;
+        params << "parameter=" << opt.parameter
+               << " rmse=" << opt.rmse;
+        key.params = params.str();
+        return key;
     }
 
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
@@ -194,6 +357,8 @@ namespace {
             {"rmse", optional_argument, NULL, 'r'},
             {"parameter", required_argument, NULL, 'p'},
             {"verbose", no_argument, NULL, 'v'},
+            {"threads", required_argument, NULL, 'j'},
+            {"db", required_argument, NULL, 'b'},
             {NULL, 0, NULL, 0}};
         opt.s_dim = 0;
         opt.start_m = 0;
@@ -203,13 +368,14 @@ namespace {
         opt.dn_id = -1;
         opt.rmse = 0;
         opt.parameter = 0;
+        opt.threads = 1;
         opt.verbose = false;
         errno = 0;
 #if defined(DEBUG)
         cout << "parse_opt step 2" << endl;
 #endif
         for (;;) {
-            c = getopt_long(argc, argv, "s:m:M:S:n:d:r:p:v", longopts, NULL);
+            c = getopt_long(argc, argv, "s:m:M:S:n:d:r:p:vj:b:", longopts, NULL);
             if (error) {
                 break;
             }
@@ -277,6 +443,16 @@ namespace {
                     error = true;
                 }
                 break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'b':
+                opt.dbfile = optarg;
+                break;
             case 'v':
                 opt.verbose = true;
                 break;
@@ -307,8 +483,8 @@ namespace {
         return true;
     }
 
-    template<typename D>
-    double integral(Saipack& func, D& digitalNet, int count,
+    template<typename F, typename D>
+    double integral(F& func, D& digitalNet, int count,
                     double expected, int rmse,
                     bool verbose)
     {
@@ -317,16 +493,13 @@ namespace {
         cout << "count = " << dec << count << endl;
         cout << "rmse = " << dec << rmse << endl;
 #endif
+        int dim = digitalNet.getS();
         // RMSE　Root Mean Squared Error
         if (rmse > 0) {
             Kahan esum;
-            for (int z = 0; z < 100; z++) {
-                Kahan sum;
-                for (int i = 0; i < count; i++) {
-                    const double *tuple = digitalNet.getPoint();
-                    sum.add(func(tuple));
-                    digitalNet.nextPoint();
-                }
+            for (int z = 0; z < rmse; z++) {
+                KahanLanes sum;
+                saipack_sum_points(sum, func, digitalNet, count, dim);
                 double er = expected - sum.get() / count;
 #if defined(DEBUG)
                 cout << "expected = " << expected << endl;
@@ -336,14 +509,10 @@ namespace {
                 digitalNet.setDigitalShift(true);
                 digitalNet.pointInitialize();
             }
-            return sqrt(esum.get() / 100);
+            return sqrt(esum.get() / rmse);
         } else {
-            Kahan sum;
-            for (int i = 0; i < count; i++) {
-                const double *tuple = digitalNet.getPoint();
-                sum.add(func(tuple));
-                digitalNet.nextPoint();
-            }
+            KahanLanes sum;
+            saipack_sum_points(sum, func, digitalNet, count, dim);
 #if defined(DEBUG)
             cout << "expected = " << expected << endl;
 #endif
@@ -353,4 +522,32 @@ namespace {
             return abs(expected - sum.get() / count);
         }
     }
+
+    /**
+     * the same as integral(), but points or RMSE replicas are
+     * distributed among threads.
+     * Every RMSE replica has its own digital shift made from seed.
+     */
+    template<typename F>
+    double integral_parallel(F& func, GrayCodeNet& net, int count,
+                             double expected, int rmse, bool verbose,
+                             int threads, uint64_t seed)
+    {
+        int dim = net.getS();
+        auto sum_range = [&func, dim](KahanLanes& sum, GrayCodeNet& cursor,
+                                      uint64_t n) {
+            saipack_sum_points(sum, func, cursor, n, dim);
+        };
+        // RMSE　Root Mean Squared Error
+        if (rmse > 0) {
+            return parallel_rmse(net, count, rmse, threads, seed, expected,
+                                 sum_range);
+        } else {
+            double sum = parallel_sum(net, 0, count, threads, sum_range);
+            if (verbose) {
+                cout << "calculated = " << (sum / count) << endl;
+            }
+            return abs(expected - sum / count);
+        }
+    }
 }
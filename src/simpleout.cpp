@@ -8,8 +8,15 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 //#include "kahan.hpp"
 #include "RandomNet.hpp"
+#include "GrayCodeNet.hpp"
+#include "net_file.h"
+#include "point_stream.h"
 #include <memory>
 #include <random>
 
@@ -29,13 +36,22 @@ namespace {
         char type;
         bool digital_shift;
         bool verbose;
+        char format;
+        uint64_t chunk;
         string dnfile;
+        string output;
     };
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
     void cmd_message(const string& pgm);
     template<typename D>
-    void output(D& digitalNet, int count, const string& dn_name,
-        bool digital_shift);
+    int output(D& digitalNet, int count, const string& dn_name,
+               const cmd_opt_t& opt);
+    template<typename D>
+    void output_text(D& digitalNet, int count, const string& dn_name,
+                     bool digital_shift, ostream& os);
+    template<typename D>
+    bool output_binary(D& digitalNet, int count, const cmd_opt_t& opt,
+                       FILE *fp);
     int file_sai(cmd_opt_t& opt);
     int random_sai(cmd_opt_t& opt);
 }
@@ -63,13 +79,26 @@ int main(int argc, char *argv[]) {
     DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
     DigitalNet<uint64_t> dn(dnid, opt.s_dim, opt.start_m);
     int count = 1 << opt.start_m;
-    output(dn, count, getDigitalNetName(opt.dn_id), opt.digital_shift);
-    return 0;
+    return output(dn, count, getDigitalNetName(opt.dn_id), opt);
 }
 
 namespace {
     int file_sai(cmd_opt_t& opt)
     {
+        if (is_net_file(opt.dnfile)) {
+            NetFile file;
+            if (!file.open(opt.dnfile)) {
+                cout << file.errorMessage() << endl;
+                return -1;
+            }
+            if (static_cast<uint32_t>(file.getS()) != opt.s_dim) {
+                cout << "s_dim != dn.getS()" << endl;
+                return -1;
+            }
+            GrayCodeNet dn(file.getS(), file.getM(), file.getBase());
+            int count = 1 << file.getM();
+            return output(dn, count, opt.dnfile, opt);
+        }
         ifstream dnstream(opt.dnfile);
         if (!dnstream) {
             cout << "can't open digital_net_file" << endl;
@@ -86,8 +115,7 @@ namespace {
         }
         int m = dn.getM();
         int count = 1 << m;
-        output(dn, count, opt.dnfile, opt.digital_shift);
-        return 0;
+        return output(dn, count, opt.dnfile, opt);
     }
 
     int random_sai(cmd_opt_t& opt)
@@ -98,14 +126,22 @@ namespace {
         int mask = 64;
         dn.setMask(mask);
         int count = 1 << opt.start_m;
-        output(dn, count, "Random", opt.digital_shift);
-        return 0;
+        return output(dn, count, "Random", opt);
     }
 
     void cmd_message(const string& pgm)
     {
         cout << pgm << " -s s_dim -m start_m "
-             << " [-d digitalnet_id] [-v] [-D] [digitalnet_file]" << endl;
+             << " [-d digitalnet_id] [-v] [-D] [-f format] [-c chunk]"
+             << " [-O output] [digitalnet_file]" << endl;
+        cout << "\t--format, -f\ttext, double or uint64, default text"
+             << endl;
+        cout << "\t--chunk, -c\tbinary stream of chunks of chunk points"
+             << " with headers" << endl
+             << "\t\t\tof point_stream.h, default raw values only"
+             << endl;
+        cout << "\t--output, -O\toutput file, default or - is stdout"
+             << endl;
     }
 
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
@@ -125,6 +161,9 @@ namespace {
             {"digitalnet-id", required_argument, NULL, 'd'},
             {"digital-shift", no_argument, NULL, 'D'},
             {"verbose", no_argument, NULL, 'v'},
+            {"format", required_argument, NULL, 'f'},
+            {"chunk", required_argument, NULL, 'c'},
+            {"output", required_argument, NULL, 'O'},
             {NULL, 0, NULL, 0}};
         opt.s_dim = 0;
         opt.start_m = 0;
@@ -134,12 +173,14 @@ namespace {
         opt.offset = 0;
         opt.digital_shift = false;
         opt.verbose = false;
+        opt.format = 't';
+        opt.chunk = 0;
         errno = 0;
 #if defined(DEBUG)
         cout << "parse_opt step 2" << endl;
 #endif
         for (;;) {
-            c = getopt_long(argc, argv, "s:m:t:b:o:d:vD", longopts, NULL);
+            c = getopt_long(argc, argv, "s:m:t:b:o:d:vDf:c:O:", longopts, NULL);
             if (error) {
                 break;
             }
@@ -191,12 +232,39 @@ namespace {
             case 'D':
                 opt.digital_shift = true;
                 break;
+            case 'f':
+                if (strcmp(optarg, "text") == 0) {
+                    opt.format = 't';
+                } else if (strcmp(optarg, "double") == 0) {
+                    opt.format = 'd';
+                } else if (strcmp(optarg, "uint64") == 0) {
+                    opt.format = 'u';
+                } else {
+                    cout << "format should be text, double or uint64"
+                         << endl;
+                    error = true;
+                }
+                break;
+            case 'c':
+                opt.chunk = strtoull(optarg, NULL, 10);
+                if (errno) {
+                    cout << "chunk should be a number" << endl;
+                    error = true;
+                }
+                break;
+            case 'O':
+                opt.output = optarg;
+                break;
             case '?':
             default:
                 error = true;
                 break;
             }
         }
+        if (opt.chunk > 0 && opt.format == 't') {
+            cout << "chunk needs binary format" << endl;
+            error = true;
+        }
         if (error) {
             cmd_message(pgm);
             return false;
@@ -218,25 +286,142 @@ namespace {
         return true;
     }
 
+    /**
+     * write points to opt.output or stdout in opt.format.
+     */
+    template<typename D>
+    int output(D& digitalNet, int count, const string& dn_name,
+               const cmd_opt_t& opt)
+    {
+        bool to_stdout = opt.output.empty() || opt.output == "-";
+        if (opt.format == 't') {
+            if (to_stdout) {
+                output_text(digitalNet, count, dn_name, opt.digital_shift,
+                            cout);
+                return 0;
+            }
+            ofstream ofs(opt.output);
+            if (!ofs) {
+                cout << "can't open " << opt.output << endl;
+                return -1;
+            }
+            output_text(digitalNet, count, dn_name, opt.digital_shift, ofs);
+            return 0;
+        }
+        FILE *fp = stdout;
+        if (!to_stdout) {
+            fp = fopen(opt.output.c_str(), "wb");
+            if (fp == NULL) {
+                cout << "can't open " << opt.output << endl;
+                return -1;
+            }
+        }
+        bool ok = output_binary(digitalNet, count, opt, fp);
+        if (!to_stdout && fclose(fp) != 0) {
+            ok = false;
+        }
+        if (!ok) {
+            // stdout may be the stream of points
+            cerr << "can't write points" << endl;
+            return -1;
+        }
+        return 0;
+    }
+
     //単純に出力するだけ
     template<typename D>
-    void output(D& digitalNet, int count, const string& dn_name,
-                bool digital_shift)
+    void output_text(D& digitalNet, int count, const string& dn_name,
+                     bool digital_shift, ostream& os)
     {
         int s = digitalNet.getS();
-        cout << "# " << dn_name << " digital_shift = " << digital_shift << endl;
-        cout << "# s = " << dec << s << endl;
-        cout << "# count = " << dec << count << endl;
-        cout << scientific << setprecision(18);
+        os << "# " << dn_name << " digital_shift = " << digital_shift << endl;
+        os << "# s = " << dec << s << endl;
+        os << "# count = " << dec << count << endl;
+        os << scientific << setprecision(18);
         digitalNet.setDigitalShift(digital_shift);
         digitalNet.pointInitialize();
         for (int i = 0; i < count; i++) {
             const double *tuple = digitalNet.getPoint();
             for (int j = 0; j < s; j++) {
-                cout << tuple[j] << ",";
+                os << tuple[j] << ",";
             }
-            cout << endl;
+            os << endl;
             digitalNet.nextPoint();
         }
     }
+
+    /**
+     * write points as binary stream of point_stream.h.
+     * Points are gathered into a block of about 1MB, or a chunk, and
+     * the block is written by one fwrite.
+     * @return false if writing failed
+     */
+    template<typename D>
+    bool output_binary(D& digitalNet, int count, const cmd_opt_t& opt,
+                       FILE *fp)
+    {
+        const size_t block_bytes = 1 << 20;
+        int s = digitalNet.getS();
+        bool as_double = opt.format == 'd';
+        uint64_t block = opt.chunk;
+        if (block == 0) {
+            block = max<uint64_t>(1, block_bytes / (s * sizeof(uint64_t)));
+        }
+        block = min<uint64_t>(block, count);
+        vector<uint64_t> base;
+        vector<double> point;
+        if (as_double) {
+            point.resize(block * s);
+        } else {
+            base.resize(block * s);
+        }
+        if (opt.chunk > 0) {
+            PointStreamHeader header;
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, "DNETPTS", 8);
+            header.byte_order = UINT64_C(0x0102030405060708);
+            header.version = POINT_STREAM_VERSION;
+            header.header_size = sizeof(header);
+            header.format = as_double ? POINT_STREAM_DOUBLE
+                : POINT_STREAM_UINT64;
+            header.s = s;
+            header.count = count;
+            header.chunk = opt.chunk;
+            if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+                return false;
+            }
+        }
+        digitalNet.setDigitalShift(opt.digital_shift);
+        digitalNet.pointInitialize();
+        for (uint64_t first = 0; first < static_cast<uint64_t>(count);
+             first += block) {
+            uint64_t points = min<uint64_t>(block, count - first);
+            for (uint64_t k = 0; k < points; k++) {
+                if (as_double) {
+                    const double *tuple = digitalNet.getPoint();
+                    copy(tuple, tuple + s, &point[k * s]);
+                } else {
+                    const uint64_t *tuple = digitalNet.getPointBase();
+                    copy(tuple, tuple + s, &base[k * s]);
+                }
+                digitalNet.nextPoint();
+            }
+            if (opt.chunk > 0) {
+                PointChunkHeader chunk;
+                chunk.first = first;
+                chunk.points = points;
+                if (fwrite(&chunk, sizeof(chunk), 1, fp) != 1) {
+                    return false;
+                }
+            }
+            size_t size = points * s;
+            size_t written = as_double
+                ? fwrite(&point[0], sizeof(double), size, fp)
+                : fwrite(&base[0], sizeof(uint64_t), size, fp);
+            if (written != size) {
+                return false;
+            }
+        }
+        return fflush(fp) == 0;
+    }
 }
@@ -6,6 +6,7 @@
 #include <string>
 #include "adjust_parameters.h"
 #include "make_parameters.h"
+#include "workspace.hpp"
 
 using namespace std;
 
@@ -30,16 +31,11 @@ int main(int argc, char * argv[])
     int genz_no = opt.genz_no;
     int seed = 1;
     int original = 1;
-    double a[dim];
-    double b[dim];
-    double alpha[dim];
-    double beta[dim];
-    for (int i = 0; i < dim; i++) {
-        a[i] = 0;
-        b[i] = 0;
-        alpha[i] = 0;
-        beta[i] = 0;
-    }
+    MCQMCIntegration::Workspace work;
+    double *a = work.alloc(dim);
+    double *b = work.alloc(dim);
+    double *alpha = work.alloc(dim);
+    double *beta = work.alloc(dim);
     cout << "#dim = " << dim << endl;
     makeParameter(genz_no, dim, seed, original, a, b, alpha, beta, false);
     double expect = adjustParameter(genz_no, dim, a, b,
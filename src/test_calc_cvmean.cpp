@@ -5,12 +5,14 @@
 #include <cerrno>
 #include <cmath>
 #include <cfloat>
+#include <cstring>
 
 using namespace std;
 
 namespace {
     int test_cvmean();
     int output_cvmean(int argc, char * argv[]);
+    int fill_cvmean(int argc, char * argv[]);
     struct check {
         int s;
         double c;
@@ -33,6 +35,8 @@ int main(int argc, char * argv[])
 {
     if (argc == 1) {
         return test_cvmean();
+    } else if (strcmp(argv[1], "fill") == 0) {
+        return fill_cvmean(argc, argv);
     } else {
         return output_cvmean(argc, argv);
     }
@@ -55,10 +59,45 @@ namespace {
         return 0;
     }
 
+    /**
+     * make cache file of c for s = 33, ..., max_s, see CVMEAN_CACHE
+     * in cvmean.h.
+     */
+    int fill_cvmean(int argc, char * argv[])
+    {
+        if (argc <= 3) {
+            cout << argv[0] << " fill cache_file max_s [threads]" << endl;
+            return -1;
+        }
+        errno = 0;
+        int max_s = strtol(argv[3], NULL, 10);
+        int threads = 1;
+        if (argc > 4) {
+            threads = strtol(argv[4], NULL, 10);
+        }
+        if (errno) {
+            cout << "max_s and threads should be number" << endl;
+            return -1;
+        }
+        // keep c already in the file
+        cvmean_load_cache(argv[2]);
+        int failed = cvmean_fill(max_s, 64, threads);
+        if (!cvmean_save_cache(argv[2])) {
+            cout << "can't write " << argv[2] << endl;
+            return -1;
+        }
+        if (failed > 0) {
+            cout << "c of " << failed << " s can't be calculated" << endl;
+            return -1;
+        }
+        return 0;
+    }
+
     int output_cvmean(int argc, char * argv[])
     {
         if (argc <= 2) {
             cout << argv[0] << " s n" << endl;
+            cout << argv[0] << " fill cache_file max_s [threads]" << endl;
             return -1;
         }
         errno = 0;
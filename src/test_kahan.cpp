@@ -0,0 +1,98 @@
+#include "kahan.hpp"
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+/*
+ * Sums of 2^30 (or 2^argv[1]) values by Kahan and KahanLanes are
+ * compared with the exact sum. Values are multiples of 2^-60 with
+ * magnitudes from 4 down to 2^-40 and random signs, and the exact sum is
+ * computed as an integer.
+ */
+namespace {
+    const int block = 4096;
+    const double unit = 1.0 / 1152921504606846976.0; // 2^-60
+
+    double ulp_error(double x, double exact) {
+        return fabs(x - exact) / (nextafter(fabs(exact), INFINITY)
+                                  - fabs(exact));
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    int log_n = 30;
+    if (argc > 1) {
+        log_n = strtol(argv[1], NULL, 10);
+    }
+    uint64_t n = UINT64_C(1) << log_n;
+    mt19937_64 mt(1);
+    vector<double> x(block);
+    __int128 exact = 0;
+    Kahan kahan;
+    KahanLanes lanes;
+    double naive = 0.0;
+    double kahan_time = 0.0;
+    double lanes_time = 0.0;
+    for (uint64_t i = 0; i < n; i += block) {
+        for (int j = 0; j < block; j++) {
+            uint64_t r = mt();
+            int64_t v = static_cast<int64_t>((r >> 2) >> (r & 0x3f) % 41);
+            if (r & 0x40) {
+                v = -v;
+            }
+            // v should be exact in double
+            v = static_cast<int64_t>(static_cast<double>(v));
+            x[j] = static_cast<double>(v) * unit;
+            exact += v;
+            naive += x[j];
+        }
+        clock_t c0 = clock();
+        kahan.add(&x[0], block);
+        clock_t c1 = clock();
+        lanes.add(&x[0], block);
+        clock_t c2 = clock();
+        kahan_time += static_cast<double>(c1 - c0) / CLOCKS_PER_SEC;
+        lanes_time += static_cast<double>(c2 - c1) / CLOCKS_PER_SEC;
+    }
+    double exact_sum = static_cast<double>(
+        static_cast<long double>(exact) * static_cast<long double>(unit));
+    double kahan_err = ulp_error(kahan.get(), exact_sum);
+    double lanes_err = ulp_error(lanes.get(), exact_sum);
+    cout << "n = 2^" << log_n << endl;
+    cout << setprecision(17);
+    cout << "exact = " << exact_sum << endl;
+    cout << "naive error = " << ulp_error(naive, exact_sum) << " ulp" << endl;
+    cout << "kahan error = " << kahan_err << " ulp "
+         << kahan_time << " s" << endl;
+    cout << "lanes error = " << lanes_err << " ulp "
+         << lanes_time << " s" << endl;
+    // one ulp for the rounding of exact_sum
+    if (lanes_err > kahan_err + 1.0) {
+        cout << "KahanLanes is less accurate than Kahan" << endl;
+        return -1;
+    }
+    KahanLanes a;
+    KahanLanes b;
+    KahanLanes whole;
+    for (int j = 0; j < block; j++) {
+        if (j < block / 3) {
+            a.add(x[j]);
+        } else {
+            b.add(x[j]);
+        }
+        whole.add(x[j]);
+    }
+    a.merge(b);
+    if (ulp_error(a.get(), whole.get()) > 1.0) {
+        cout << "merge error" << endl;
+        return -1;
+    }
+    return 0;
+}
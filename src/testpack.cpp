@@ -6,12 +6,23 @@
 # include <string.h>
 # include "testpack.h"
 #include "kahan.hpp"
+#include "corner_expect.h"
+#include "thread_pool.hpp"
 
 #define UNUSED(x) (void)(x)
 //#define DEBUG
 
 using namespace std;
 
+//
+//  the integration subroutine tested by MULTST, such as ADAPT.
+//
+typedef void multst_subrtn ( int ndim, double a[], double b[], int *minpts,
+  int maxpts, double functn ( int indx, int ndim, const double z[],
+  const double alpha[], const double beta[] ), double rel_tol, int itest,
+  double alpha[], double beta[], int lenwrk, double wrkstr[],
+  double *errest, double *finest, int *ifail );
+
 #if defined(MAIN)
 //****************************************************************************80
 
@@ -90,9 +101,10 @@ int main ( void )
 //****************************************************************************80
 
 void adapt ( int ndim, double a[], double b[], int *minpts, int maxpts,
-  double functn ( int indx, int ndim, double z[], double alpha[],
-  double beta[] ), double rel_tol, int itest, double alpha[], double beta[],
-  int lenwrk, double wrkstr[], double *relerr, double *finest, int *ifail )
+  double functn ( int indx, int ndim, const double z[], const double alpha[],
+  const double beta[] ), double rel_tol, int itest, double alpha[],
+  double beta[], int lenwrk, double wrkstr[], double *relerr, double *finest,
+  int *ifail )
 
 //****************************************************************************80
 //
@@ -137,8 +149,8 @@ void adapt ( int ndim, double a[], double b[], int *minpts, int maxpts,
 //
 //    Input, external, double FUNCTN, the user-defined function
 //    to be integrated.  It must have the form
-//      double functn ( int indx, ind ntim, double z[], double alpha[],
-//        double beta[] )
+//      double functn ( int indx, int ndim, const double z[],
+//        const double alpha[], const double beta[] )
 //    where
 //      INDX is the index of the test function,
 //      NDIM is the spatial dimension,
@@ -889,6 +901,178 @@ double genz_function ( int indx, int ndim, const double z[],
 }
 //****************************************************************************80
 
+void genz_function_block ( int indx, int ndim, int n, const double z[],
+                           const double alpha[], const double beta[],
+                           double value[] )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    GENZ_FUNCTION_BLOCK evaluates one of the test integrand functions
+//    at a block of points.
+//
+//  Discussion:
+//
+//    The values are the same as N calls of GENZ_FUNCTION, but the
+//    selection of the function and the setup which depends only on
+//    ALPHA and BETA are done once for the whole block.
+//
+//  Parameters:
+//
+//    Input, int INDX, the index of the test function.
+//
+//    Input, int NDIM, the spatial dimension.
+//
+//    Input, int N, the number of points.
+//
+//    Input, double Z[N*NDIM], the points, Z[I*NDIM+J] is the J-th
+//    coordinate of the I-th point.
+//
+//    Input, double ALPHA[NDIM], BETA[NDIM], parameters
+//    associated with the integrand function.
+//
+//    Output, double VALUE[N], the values of the test function.
+//
+{
+  int i;
+  int j;
+  const double pi = 3.14159265358979323844;
+  const double *x;
+  bool test;
+  double total;
+  double c;
+  double *w;
+//
+//  Oscillatory.
+//
+  if ( indx == 1 )
+  {
+    c = 2.0 * pi * beta[0];
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      total = c + r8vec_mulsum ( ndim, alpha, x );
+      value[i] = cos ( total );
+    }
+  }
+//
+//  Product Peak.
+//
+  else if ( indx == 2 )
+  {
+    w = new double[ndim];
+    for ( j = 0; j < ndim; j++ )
+    {
+      w[j] = 1.0 / pow ( alpha[j], 2 );
+    }
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      total = 1.0;
+      for ( j = 0; j < ndim; j++ )
+      {
+        total = total * ( w[j] + pow ( x[j] - beta[j], 2 ) );
+      }
+      value[i] = 1.0 / total;
+    }
+    delete [] w;
+  }
+//
+//  Corner Peak.
+//
+  else if ( indx == 3 )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      total = 1.0;
+      for ( j = 0; j < ndim; j++ )
+      {
+        if ( beta[j] < 0.5 )
+        {
+          total = total + x[j];
+        }
+        else
+        {
+          total = total + alpha[j] - x[j];
+        }
+      }
+      value[i] = 1.0 / pow ( total, ndim + 1 );
+    }
+  }
+//
+//  Gaussian.
+//
+  else if ( indx == 4 )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      total = 0.0;
+      for ( j = 0; j < ndim; j++ )
+      {
+        total = total + pow ( alpha[j] * ( x[j] - beta[j] ), 2 );
+      }
+      total = r8_min ( total, 100.0 );
+      value[i] = exp ( - total );
+    }
+  }
+//
+//  C0 Function.
+//
+  else if ( indx == 5 )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      total = 0.0;
+      for ( j = 0; j < ndim; j++ )
+      {
+        total = total + alpha[j] * r8_abs ( x[j] - beta[j] );
+      }
+      value[i] = exp ( - total );
+    }
+  }
+//
+//  Discontinuous.
+//
+  else if ( indx == 6 )
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      x = z + i * ndim;
+      test = false;
+      for ( j = 0; j < ndim; j++ )
+      {
+        if ( beta[j] < x[j] )
+        {
+          test = true;
+          break;
+        }
+      }
+      if ( test )
+      {
+        value[i] = 0.0;
+      }
+      else
+      {
+        total = r8vec_dot ( ndim, alpha, x );
+        value[i] = exp ( total );
+      }
+    }
+  }
+  else
+  {
+    for ( i = 0; i < n; i++ )
+    {
+      value[i] = 0.0;
+    }
+  }
+  return;
+}
+//****************************************************************************80
+
 double genz_integral ( int indx, int ndim, double a[], double b[],
   double alpha[], double beta[] )
 
@@ -949,15 +1133,17 @@ double genz_integral ( int indx, int ndim, double a[], double b[],
     cout << "}" << endl;
 #endif
   double ab;
-  int *ic;
-  int isum;
   int j;
   const double pi = 3.14159265358979323844;
+  double value;
+#if 0 // used by the sums over 2^ndim corners
+  int *ic;
+  int isum;
   int rank;
   double s;
   double sgndm;
   double total;
-  double value;
+#endif
 //
 //  Oscillatory.
 //
@@ -1050,6 +1236,7 @@ double genz_integral ( int indx, int ndim, double a[], double b[],
 //  Corner Peak.
 //
   else if ( indx == 3 )
+#if 0
   {
     value = 0.0;
 
@@ -1092,6 +1279,12 @@ double genz_integral ( int indx, int ndim, double a[], double b[],
 
     value = value * sgndm;
   }
+#else
+  // The same sum by one dimensional integral, O(ndim) instead of 2^ndim.
+  {
+    value = cornerpeak_expect ( ndim, alpha );
+  }
+#endif
 //
 //  Gaussian.
 //
@@ -1393,6 +1586,46 @@ double genz_random ( int *seed )
 }
 //****************************************************************************80
 
+int genz_random_skip ( int seed, long long n )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    GENZ_RANDOM_SKIP returns the seed after N calls of GENZ_RANDOM.
+//
+//  Discussion:
+//
+//    GENZ_RANDOM multiplies SEED by 16807 modulo 2^31 - 1, so the seed
+//    after N calls is SEED * 16807^N, computed by repeated squaring.
+//
+//  Parameters:
+//
+//    Input, int SEED, a seed for GENZ_RANDOM, 1 <= SEED < 2^31 - 1.
+//
+//    Input, long long N, the number of calls to skip.
+//
+//    Output, int GENZ_RANDOM_SKIP, the seed after N calls.
+//
+{
+  long long f = 16807;
+  const long long p = 2147483647;
+  long long x = seed;
+
+  while ( 0 < n )
+  {
+    if ( n % 2 == 1 )
+    {
+      x = ( x * f ) % p;
+    }
+    f = ( f * f ) % p;
+    n = n / 2;
+  }
+
+  return ( int ) x;
+}
+//****************************************************************************80
+
 int i4_max ( int i1, int i2 )
 
 //****************************************************************************80
@@ -1590,7 +1823,7 @@ int i4vec_sum ( int n, int a[] )
 //****************************************************************************80
 
 void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
-  double expnts[], int ndiml, int ndims[], char *sbname,
+  double expnts[], int ndiml, int ndims[], const char *sbname,
   void subrtn ( int ndim, double a[], double b[], int *minpts, int maxpts,
     double functn ( int indx, int ndim, const double z[], const double alpha[],
       const double beta[] ),
@@ -1610,6 +1843,8 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
 //    the user selecting the particular subset of test integrands,
 //    the set of difficulty factors, and the spatial dimensions.
 //
+//    This is MULTST_PARALLEL with one thread.
+//
 //  Modified:
 //
 //    26 May 2007
@@ -1651,7 +1886,7 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
 //    Input, int NDIMS[NDIML], the number of variables for the integrals
 //    in each test.
 //
-//    Input, char *SBNAME, the name of the integration
+//    Input, const char *SBNAME, the name of the integration
 //    subroutine to be tested.
 //
 //    Input, external SUBRTN, the integration subroutine to be tested.
@@ -1662,21 +1897,212 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
 //    for all tests.
 //
 {
-    UNUSED(tstmax);
-# define MXTSFN 6
+  multst_parallel ( nsamp, tstlim, tstfns, tstmax, difclt, expnts, ndiml,
+    ndims, sbname, subrtn, rel_tol, maxpts, 1 );
 
+  return;
+}
+//****************************************************************************80
+
+static void multst_sample ( int ndim, int itest, double exn, double dfclt,
+  int seed, multst_subrtn *subrtn, double rel_tol, int maxpts,
+  double small, double *estlog, double *errlog, double *dscrep,
+  double *calls, int *reliab, int *ifail )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    MULTST_SAMPLE runs one sample of one test integrand for MULTST.
+//
+//  Discussion:
+//
+//    The integrand parameters are drawn by GENZ_RANDOM starting from
+//    SEED, and all the work arrays are local, so samples can be run
+//    concurrently.
+//
+//  Parameters:
+//
+//    Input, int NDIM, the number of variables.
+//
+//    Input, int ITEST, the index of the test integrand.
+//
+//    Input, double EXN, DFCLT, the difficulty exponent and level.
+//
+//    Input, int SEED, the seed of the integrand parameters.
+//
+//    Input, external SUBRTN, the integration subroutine to be tested.
+//
+//    Input, double REL_TOL, the relative error tolerance.
+//
+//    Input, int MAXPTS, the maximum number of integrand calls.
+//
+//    Input, double SMALL, the smallest relative error.
+//
+//    Output, double *ESTLOG, *ERRLOG, *DSCREP, the estimated and
+//    actual correct digits and the wrong digits.
+//
+//    Output, double *CALLS, the number of integrand calls.
+//
+//    Output, int *RELIAB, 1 if the error estimate is reliable.
+//
+//    Output, int *IFAIL, the error indicator of SUBRTN.
+//
+{
   double *a;
   double *alpha;
   double *b;
   double *beta;
+  double dfact;
+  double errest;
+  double finest;
+  int j;
+  int lenwrk;
+  int minpts;
+  int n;
+  double relerr;
+  int rulcls;
+  double total;
+  double value;
+  double *wrkstr;
+
+  a = new double[ndim];
+  alpha = new double[ndim];
+  b = new double[ndim];
+  beta = new double[ndim];
+
+  if ( ndim <= 15 )
+  {
+    rulcls = i4_power ( 2, ndim ) + 2 * i4_power ( ndim, 2 ) + 2 * ndim + 1;
+  }
+  else
+  {
+    rulcls = ( ndim * ( 14 - ndim * ( 6 - 4 * ndim ) ) ) / 3 + 1;
+  }
+
+  lenwrk = ( 2 * ndim + 3 ) * ( 1 + maxpts / rulcls ) / 2;
+  wrkstr = new double[lenwrk];
+
+  for ( j = 0; j < ndim; j++ )
+  {
+    a[j] = 0.0;
+  }
+  for ( j = 0; j < ndim; j++ )
+  {
+    b[j] = 1.0;
+  }
+  *ifail = 1;
+//
+//  Choose the integrand function parameters at random.
+//
+  for ( n = 0; n < ndim; n++ )
+  {
+    alpha[n] = genz_random ( &seed );
+    beta[n] = genz_random ( &seed );
+  }
+//
+//  Modify ALPHA to account for difficulty parameter.
+//
+  total = r8vec_sum ( ndim, alpha );
+  dfact = total * pow ( ndim, exn ) / dfclt;
+  for ( j = 0; j < ndim; j++ )
+  {
+    alpha[j] = alpha[j] / dfact;
+  }
+//
+//  For test 3, we modify the value of B.  The original did this for
+//  test 1 too, but GENZ_FUNCTION 1 here is the original integrand
+//  over [0,ALPHA] moved to the unit cube, as GENZ_INTEGRAL 1.
+//
+  if ( itest == 3 )
+  {
+    for ( j = 0; j < ndim; j++ )
+    {
+      b[j] = alpha[j];
+    }
+  }
+//
+//  For test 6, we modify the value of BETA.
+//
+  if ( itest == 6 )
+  {
+    for ( n = 2; n < ndim; n++ )
+    {
+      beta[n] = 1.0;
+    }
+  }
+//
+//  Get the exact value of the integral.
+//
+  value = genz_integral ( itest, ndim, a, b, alpha, beta );
+//
+//  Call the integration subroutine.
+//
+  minpts = 4 * i4_power ( 2, ndim );
+
+  subrtn ( ndim, a, b, &minpts, maxpts, genz_function, rel_tol,
+    itest, alpha, beta, lenwrk, wrkstr, &errest, &finest, ifail );
+
+  relerr = r8_abs ( ( finest - value ) / value );
+  relerr = r8_max ( r8_min ( 1.0, relerr ), small );
+  *errlog = r8_max ( 0.0, -log10 ( relerr ) );
+  errest = r8_max ( r8_min ( 1.0, errest ), small );
+  *estlog = r8_max ( 0.0, -log10 ( errest ) );
+  *dscrep = r8_max ( 0.0, *estlog - *errlog );
+  *calls = minpts;
+  *reliab = ( relerr <= errest ) ? 1 : 0;
+
+  delete [] a;
+  delete [] alpha;
+  delete [] b;
+  delete [] beta;
+  delete [] wrkstr;
+
+  return;
+}
+//****************************************************************************80
+
+void multst_parallel ( int nsamp, int tstlim, int tstfns[], int tstmax,
+  double difclt[], double expnts[], int ndiml, int ndims[],
+  const char *sbname, multst_subrtn *subrtn, double rel_tol, int maxpts,
+  int threads )
+
+//****************************************************************************80
+//
+//  Purpose:
+//
+//    MULTST_PARALLEL tests a multidimensional integration routine by
+//    threads.
+//
+//  Discussion:
+//
+//    Every sample of every test integrand and number of variables is
+//    an independent task, and the tasks are run by THREADS threads,
+//    which take the next task when they finish one.  The tables are
+//    printed after all tasks are finished.
+//
+//    MULTST draws the integrand parameters of all samples from one
+//    stream of GENZ_RANDOM starting from 123456.  Here each task gets
+//    the seed of the stream at the place of its sample, computed by
+//    GENZ_RANDOM_SKIP, so the parameters and the tables are the same
+//    as MULTST for any THREADS, if SUBRTN doesn't depend on the
+//    previous calls.
+//
+//  Parameters:
+//
+//    The parameters are the same as MULTST, and
+//
+//    Input, int THREADS, the number of threads.  If THREADS <= 1,
+//    the tasks are run in the calling thread in the order of MULTST.
+//
+{
+    UNUSED(tstmax);
+# define MXTSFN 6
+
   double callsa[MXTSFN*MXTSFN];
   double callsb[MXTSFN*MXTSFN];
   double concof;
-  double dfact;
-  double dfclt;
   int digits;
-  double errest;
-  double errlog;
   double ersacb[MXTSFN*MXTSFN];
   double ersact[MXTSFN*MXTSFN];
   double ersdsb[MXTSFN*MXTSFN];
@@ -1684,19 +2110,14 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
   double ersesb[MXTSFN*MXTSFN];
   double ersest[MXTSFN*MXTSFN];
   double ersrel[MXTSFN*MXTSFN];
-  double estlog;
-  double exn;
   double expons[MXTSFN];
-  double finest;
   int i;
   int idfclt[MXTSFN];
-  int ifail;
   int ifails;
   int it;
   int itest;
   int j;
   int k;
-  int lenwrk;
   double medacb[MXTSFN];
   double medacb_med[3];
   double *medact;
@@ -1718,22 +2139,26 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
   double medrel;
   double *medrll;
   double medrll_med[3];
-  int minpts;
-  int n;
   char *name;
   int nconf;
   int ndim;
   int ndimv;
+  int ntask;
   double qality;
   double *qallty;
   double qallty_med[3];
   double qualty[MXTSFN*MXTSFN];
   int rcalsa;
   int rcalsb;
-  double relerr;
-  int rulcls;
   int seed;
   double small;
+  double *smpact;
+  double *smpcls;
+  double *smpdsc;
+  double *smpest;
+  int *smpfai;
+  int *smprel;
+  int *smpsed;
   double tactrb[MXTSFN];
   double tactrb_med[3];
   double tactrs[MXTSFN];
@@ -1742,6 +2167,7 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
   double tcalsa_med[3];
   double tcalsb[MXTSFN];
   double tcalsb_med[3];
+  int task;
   double terdsb[MXTSFN];
   double terdsb_med[3];
   double terdsc[MXTSFN];
@@ -1752,11 +2178,8 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
   double testrs_med[3];
   double tqualt[MXTSFN];
   double tqualt_med[3];
-  double total;
   double trelib[MXTSFN];
   double trelib_med[3];
-  double value;
-  double *wrkstr;
 
   medact = new double[nsamp];
   medcls = new double[nsamp];
@@ -1778,8 +2201,6 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
 
   concof = 1.0 - concof / ( double ) ( i4_power ( 2, nsamp - 1 ) );
 
-  seed = 123456;
-
   small = r8_epsilon ( );
 
   for ( i = 0; i < tstlim; i++ )
@@ -1791,28 +2212,67 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
     expons[i] = expnts[tstfns[i]-1];
   }
 //
-//  Begin main loop for different numbers of variables.
+//  The task of sample K of test IT with NDIMS[NDIMV] variables is
+//  ( NDIMV * TSTLIM + IT ) * NSAMP + K, and it draws 2 * NDIM values
+//  of the stream after the tasks before it.
 //
+  ntask = ndiml * tstlim * nsamp;
+  smpact = new double[ntask];
+  smpcls = new double[ntask];
+  smpdsc = new double[ntask];
+  smpest = new double[ntask];
+  smpfai = new int[ntask];
+  smprel = new int[ntask];
+  smpsed = new int[ntask];
+
+  seed = 123456;
+  task = 0;
   for ( ndimv = 0; ndimv < ndiml; ndimv++ )
   {
-    ndim = ndims[ndimv];
+    for ( k = 0; k < tstlim * nsamp; k++ )
+    {
+      smpsed[task] = seed;
+      seed = genz_random_skip ( seed, 2 * ndims[ndimv] );
+      task = task + 1;
+    }
+  }
 
-    a = new double[ndim];
-    alpha = new double[ndim];
-    b = new double[ndim];
-    beta = new double[ndim];
+  auto run = [&] ( int task )
+  {
+    int ndimv = task / ( tstlim * nsamp );
+    int itest = tstfns[( task / nsamp ) % tstlim];
 
-    if ( ndim <= 15 )
+    multst_sample ( ndims[ndimv], itest, expnts[itest-1],
+      difclt[itest-1], smpsed[task], subrtn, rel_tol, maxpts, small,
+      smpest + task, smpact + task, smpdsc + task, smpcls + task,
+      smprel + task, smpfai + task );
+  };
+
+  if ( threads <= 1 )
+  {
+    for ( task = 0; task < ntask; task++ )
     {
-      rulcls = i4_power ( 2, ndim ) + 2 * i4_power ( ndim, 2 ) + 2 * ndim + 1;
+      run ( task );
     }
-    else
+  }
+  else
+  {
+//
+//  The samples with more variables take longer, so they are given first.
+//
+    MCQMCIntegration::ThreadPool pool ( threads );
+    for ( task = ntask - 1; 0 <= task; task-- )
     {
-      rulcls = ( ndim * ( 14 - ndim * ( 6 - 4 * ndim ) ) ) / 3 + 1;
+      pool.submit ( [&run, task] ( ) { run ( task ); } );
     }
-
-    lenwrk = ( 2 * ndim + 3 ) * ( 1 + maxpts / rulcls ) / 2;
-    wrkstr = new double[lenwrk];
+    pool.wait ( );
+  }
+//
+//  Begin main loop for different numbers of variables.
+//
+  for ( ndimv = 0; ndimv < ndiml; ndimv++ )
+  {
+    ndim = ndims[ndimv];
 
     if ( ( ndimv % 6 ) == 0 )
     {
@@ -1853,86 +2313,23 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
     for ( it = 0; it < tstlim; it++ )
     {
       itest = tstfns[it];
-      exn = expnts[itest-1];
-      dfclt = difclt[itest-1];
 
-      for ( j = 0; j < ndim; j++ )
-      {
-        a[j] = 0.0;
-      }
-      for ( j = 0; j < ndim; j++ )
-      {
-        b[j] = 1.0;
-      }
       ifails = 0;
       medrel = 0;
 //
-//  Begin loop for different samples.
+//  Collect the results of the samples.
 //
       for ( k = 0; k < nsamp; k++ )
       {
-        ifail = 1;
-//
-//  Choose the integrand function parameters at random.
-//
-        for ( n = 0; n < ndim; n++ )
-        {
-          alpha[n] = genz_random ( &seed );
-          beta[n] = genz_random ( &seed );
-        }
-//
-//  Modify ALPHA to account for difficulty parameter.
-//
-        total = r8vec_sum ( ndim, alpha );
-        dfact = total * pow ( ndim, exn ) / dfclt;
-        for ( j = 0; j < ndim; j++ )
-        {
-          alpha[j] = alpha[j] / dfact;
-        }
-//
-//  For tests 1 and 3, we modify the value of B.
-//
-        if ( itest == 1 || itest == 3 )
-        {
-          for ( j = 0; j < ndim; j++ )
-          {
-            b[j] = alpha[j];
-          }
-        }
-//
-//  For test 6, we modify the value of BETA.
-//
-        if ( itest == 6 )
-        {
-          for ( n = 2; n < ndim; n++ )
-          {
-            beta[n] = 1.0;
-          }
-        }
-//
-//  Get the exact value of the integral.
-//
-        value = genz_integral ( itest, ndim, a, b, alpha, beta );
-//
-//  Call the integration subroutine.
-//
-        minpts = 4 * i4_power ( 2, ndim );
-
-        subrtn ( ndim, a, b, &minpts, maxpts, genz_function, rel_tol,
-          itest, alpha, beta, lenwrk, wrkstr, &errest, &finest, &ifail );
+        task = ( ndimv * tstlim + it ) * nsamp + k;
 
-        relerr = r8_abs ( ( finest - value ) / value );
-        ifails = ifails + i4_min ( ifail, 1 );
-        relerr = r8_max ( r8_min ( 1.0, relerr ), small );
-        errlog = r8_max ( 0.0, -log10 ( relerr ) );
-        errest = r8_max ( r8_min ( 1.0, errest ), small );
-        estlog = r8_max ( 0.0, -log10 ( errest ) );
-        meddsc[k] = r8_max ( 0.0, estlog - errlog );
-        medest[k] = estlog;
-        medact[k] = errlog;
-        medcls[k] = minpts;
+        ifails = ifails + i4_min ( smpfai[task], 1 );
+        meddsc[k] = smpdsc[task];
+        medest[k] = smpest[task];
+        medact[k] = smpact[task];
+        medcls[k] = smpcls[task];
 
-        if ( relerr <= errest )
+        if ( smprel[task] )
         {
           medrel = medrel + 1;
         }
@@ -2034,11 +2431,6 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
 
     cout << "\n";
 
-    delete [] a;
-    delete [] alpha;
-    delete [] b;
-    delete [] beta;
-    delete [] wrkstr;
   }
 //
 //  End loop for different numbers of variables.
@@ -2156,6 +2548,13 @@ void multst ( int nsamp, int tstlim, int tstfns[], int tstmax, double difclt[],
   delete [] medest;
   delete [] medrll;
   delete [] qallty;
+  delete [] smpact;
+  delete [] smpcls;
+  delete [] smpdsc;
+  delete [] smpest;
+  delete [] smpfai;
+  delete [] smprel;
+  delete [] smpsed;
 
   return;
 # undef MXTSFN
@@ -1,4 +1,5 @@
 #define _USE_MATH_DEFINES
+#include "config.h"
 #include <math.h>
 #include <cerrno>
 #include <getopt.h>
@@ -8,13 +9,33 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
 #include "testpack.h"
+#include "genz_simd.h"
+#include "genz_sum.hpp"
 #include "kahan.hpp"
 #include "make_parameters.h"
 #include "make_wafomc_parameters.h"
 #include "RandomNet.hpp"
 #include "adjust_parameters.h"
+#include "GrayCodeNet.hpp"
+#include "parallel_sum.hpp"
+#include "result_store.h"
+#include "net_file.h"
+#include "bounded_queue.hpp"
+#include "workspace.hpp"
 #include <time.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#if defined(HAVE_MPI_H)
+#include <mpi.h>
+#else
+#define MPI_Finalize()
+#endif
 
 using namespace std;
 using namespace MCQMCIntegration;
@@ -37,91 +58,345 @@ namespace {
         bool adjust;
         bool wafom;
         int digital_shift;
+        int threads;
+        bool nested;
         bool linearScramble;
+        bool batch;
+        int io_threads;
+        int prefetch;
+        vector<int> genz_list;
         string dnfile;
+        string dbfile;
+        int rank;
+        int num_process;
+    };
+
+    /**
+     * a digital net read by an I/O thread in batch mode.
+     */
+    struct batch_net_t {
+        size_t index;
+        int s;
+        int m;
+        vector<uint64_t> mat;
+        string message;
     };
 
+    /**
+     * a row of the result table of batch mode.
+     */
+    struct batch_result_t {
+        int s;
+        int m;
+        double error;
+        string message;
+    };
+
+    int testpack_main(int argc, char *argv[], int rank, int num_process);
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
     void cmd_message(const string& pgm);
     template<typename D>
-    double integral(int func_index, D& digitalNet, int count, int dim,
+    double integral(int func_index, D& digitalNet, uint64_t count, int dim,
                     double alpha[], double beta[], double expected, int rmse,
                     bool verbose, int digital_shift);
+    double integral_parallel(int func_index, GrayCodeNet& net,
+                             uint64_t count, int dim, double alpha[],
+                             double beta[], double expected, int rmse,
+                             bool verbose, int digital_shift, int threads,
+                             uint64_t seed);
     int file_genz(cmd_opt_t& opt);
+    template<typename D>
+    int file_genz_net(cmd_opt_t& opt, ResultStore& store, D& dn);
     int random_genz(cmd_opt_t& opt);
+    int batch_genz(cmd_opt_t& opt);
+    void batch_evaluate(const cmd_opt_t& opt, ResultStore& store,
+                        mutex& store_mutex, const string& name,
+                        batch_net_t& net, batch_result_t result[]);
+    int nested_genz(cmd_opt_t& opt, ResultStore& store,
+                    double alpha[], double beta[], double expected);
+    bool is_embedded(DigitalNet<uint64_t>& dn, DigitalNetID dnid,
+                     int start_m);
+    bool clock_seeded(const cmd_opt_t& opt);
+    bool open_store(ResultStore& store, const cmd_opt_t& opt);
+    int close_store(ResultStore& store);
+    ResultKey result_key(const cmd_opt_t& opt, const string& net, int s,
+                         int m);
+    bool find_result(const cmd_opt_t& opt, ResultStore& store,
+                     const ResultKey& key, double *error);
+#if defined(HAVE_MPI_H)
+    double integral_mpi(const cmd_opt_t& opt, GrayCodeNet& net, int m,
+                        int dim, double alpha[], double beta[],
+                        double expected);
+#endif
 }
 
 int main(int argc, char *argv[]) {
-    cmd_opt_t opt;
-    if (!parse_opt(opt, argc, argv)) {
-        return -1;
-    }
-    cout << "#digital_shift = " << opt.digital_shift << endl;
-    if (opt.dn_id < 0) {
-        return file_genz(opt);
-    }
-    if (opt.dn_id >= 100) {
-        return random_genz(opt);
-    }
-    double a[opt.s_dim];
-    double b[opt.s_dim];
-    double alpha[opt.s_dim];
-    double beta[opt.s_dim];
-    for (size_t i = 0; i < opt.s_dim; i++) {
-        a[i] = 0;
-        b[i] = 0;
-        alpha[i] = 0;
-        beta[i] = 0;
-    }
-    double expected = 1.0;
-    if (opt.wafom) {
-        makeWafomParameter(opt.genz_no, opt.s_dim, opt.seed,
-                           a, b, alpha, beta, opt.verbose, opt.mag);
-        expected = genz_integral(opt.genz_no, opt.s_dim, a, b, alpha, beta);
-    } else if (opt.adjust) {
-        makeParameter(opt.genz_no, opt.s_dim, opt.seed, opt.original,
-                      a, b, alpha, beta, false, opt.difficulty);
-        expected = adjustParameter(opt.genz_no, opt.s_dim, a, b, alpha, beta,
-                                   opt.verbose);
-    } else {
-        makeParameter(opt.genz_no, opt.s_dim, opt.seed, opt.original,
-                      a, b, alpha, beta, opt.verbose, opt.difficulty);
-        expected = genz_integral(opt.genz_no, opt.s_dim, a, b, alpha, beta);
+    int rank = 0;
+    int num_process = 1;
+#if defined(HAVE_MPI_H)
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_process);
+#endif
+    int rc = testpack_main(argc, argv, rank, num_process);
+    MPI_Finalize();
+    return rc;
+}
+
+namespace {
+    /**
+     * With MPI and more than one process, every rank sums its own part
+     * of the points of the same net, see integral_mpi(), and only
+     * rank 0 prints and uses the database.
+     */
+    int testpack_main(int argc, char *argv[], int rank, int num_process)
+    {
+        if (rank != 0) {
+            // the output of rank 0 is enough
+            cout.setstate(ios::failbit);
+        }
+        cmd_opt_t opt;
+        if (!parse_opt(opt, argc, argv)) {
+            return -1;
+        }
+        opt.rank = rank;
+        opt.num_process = num_process;
+        if (num_process > 1 && (opt.batch || opt.nested || opt.rmse > 0
+                                || opt.dn_id >= 100)) {
+            cout << "MPI can't be used with batch mode, nested mode, RMSE"
+                 << " or random net" << endl;
+            return -1;
+        }
+        cout << "#digital_shift = " << opt.digital_shift << endl;
+        if (opt.verbose) {
+            cout << "#simd = " << GenzSIMD::isa() << endl;
+        }
+        if (opt.batch) {
+            return batch_genz(opt);
+        }
+        if (opt.dn_id < 0) {
+            return file_genz(opt);
+        }
+        if (opt.dn_id >= 100) {
+            return random_genz(opt);
+        }
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
+        Workspace work;
+        double *a = work.alloc(opt.s_dim);
+        double *b = work.alloc(opt.s_dim);
+        double *alpha = work.alloc(opt.s_dim);
+        double *beta = work.alloc(opt.s_dim);
+        double expected = 1.0;
+        if (opt.wafom) {
+            makeWafomParameter(opt.genz_no, opt.s_dim, opt.seed,
+                               a, b, alpha, beta, opt.verbose, opt.mag);
+            expected = genz_integral(opt.genz_no, opt.s_dim, a, b, alpha, beta);
+        } else if (opt.adjust) {
+            makeParameter(opt.genz_no, opt.s_dim, opt.seed, opt.original,
+                          a, b, alpha, beta, false, opt.difficulty);
+            expected = adjustParameter(opt.genz_no, opt.s_dim, a, b, alpha, beta,
+                                       opt.verbose);
+        } else {
+            makeParameter(opt.genz_no, opt.s_dim, opt.seed, opt.original,
+                          a, b, alpha, beta, opt.verbose, opt.difficulty);
+            expected = genz_integral(opt.genz_no, opt.s_dim, a, b, alpha, beta);
+        }
+        DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
+        cout << "#" << genz_name(opt.genz_no) << endl;
+        cout << "#" << getDigitalNetName(opt.dn_id) << endl;
+        if (opt.rmse > 0) {
+            cout << "#m, abs err, log2(RMSE[" << dec << opt.rmse << "])" << endl;
+        } else {
+            cout << "#m, abs err, log2(err)" << endl;
+        }
+        cout << "#expected = " << expected << endl;
+        if (opt.nested) {
+            if (nested_genz(opt, store, alpha, beta, expected) != 0) {
+                return -1;
+            }
+            return close_store(store);
+        }
+        for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
+            ResultKey key = result_key(opt, getDigitalNetName(opt.dn_id),
+                                       opt.s_dim, m);
+            double error;
+            if (find_result(opt, store, key, &error)) {
+                cout << dec << m << "," << error << "," << log2(error) << endl;
+                continue;
+            }
+            DigitalNet<uint64_t> dn(dnid, opt.s_dim, m);
+            if (opt.num_process > 1) {
+                // all ranks should scramble the same way
+                dn.setSeed(opt.seed);
+            } else {
+                dn.setSeed(static_cast<uint64_t>(clock()));
+            }
+            if (opt.linearScramble) {
+                dn.linearScramble();
+            }
+            if (opt.num_process > 1) {
+#if defined(HAVE_MPI_H)
+                GrayCodeNet gc(dn);
+                gc.setSeed(opt.seed);
+                error = integral_mpi(opt, gc, m, opt.s_dim, alpha, beta,
+                                     expected);
+#endif
+            } else if (opt.threads > 1 || opt.rmse > 0) {
+                uint64_t count = UINT64_C(1) << m;
+                GrayCodeNet gc(dn);
+                gc.setSeed(opt.seed);
+                error = integral_parallel(opt.genz_no, gc, count, opt.s_dim,
+                                          alpha, beta, expected, opt.rmse,
+                                          opt.verbose, opt.digital_shift,
+                                          opt.threads, opt.seed);
+            } else {
+                uint64_t count = UINT64_C(1) << m;
+                error = integral(opt.genz_no, dn, count, opt.s_dim,
+                                 alpha, beta, expected, opt.rmse, opt.verbose,
+                                 opt.digital_shift);
+            }
+            if (!store.add(key, expected, error) || !store.flush()) {
+                store.reportError();
+            }
+            cout << dec << m << "," << error << "," << log2(error) << endl;
+        }
+        return close_store(store);
     }
-    DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
-    cout << "#" << genz_name(opt.genz_no) << endl;
-    cout << "#" << getDigitalNetName(opt.dn_id) << endl;
-    if (opt.rmse > 0) {
-        cout << "#m, abs err, log2(RMSE[" << dec << opt.rmse << "])" << endl;
-    } else {
-        cout << "#m, abs err, log2(err)" << endl;
+
+    /**
+     * true if the first m rows of the generating matrices of dn are
+     * the generating matrices of the net of dnid for m,
+     * start_m <= m < dn.getM().
+     */
+    bool is_embedded(DigitalNet<uint64_t>& dn, DigitalNetID dnid,
+                     int start_m)
+    {
+        int s = dn.getS();
+        for (int m = start_m; m < static_cast<int>(dn.getM()); m++) {
+            DigitalNet<uint64_t> small(dnid, s, m);
+            for (int i = 0; i < m; i++) {
+                for (int j = 0; j < s; j++) {
+                    if (small.getBase(i, j) != dn.getBase(i, j)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
     }
-    cout << "#expected = " << expected << endl;
-    for (uint32_t m = opt.start_m; m <= opt.end_m; m++) {
-        DigitalNet<uint64_t> dn(dnid, opt.s_dim, m);
-        dn.setSeed(static_cast<uint64_t>(clock()));
-        if (opt.linearScramble) {
-            dn.linearScramble();
+
+    /**
+     * integrate by the first 2^m points of the net for end_m,
+     * for m = start_m, ..., end_m.
+     */
+    int nested_genz(cmd_opt_t& opt, ResultStore& store,
+                    double alpha[], double beta[], double expected)
+    {
+        DigitalNetID dnid = static_cast<DigitalNetID>(opt.dn_id);
+        string name = getDigitalNetName(opt.dn_id);
+        int levels = opt.end_m - opt.start_m + 1;
+        vector<double> error(levels);
+        vector<bool> stored(levels);
+        bool all_stored = true;
+        for (int k = 0; k < levels; k++) {
+            ResultKey key = result_key(opt, name, opt.s_dim, opt.start_m + k);
+            double e;
+            stored[k] = store.find(key, &e, &error[k]);
+            all_stored = all_stored && stored[k];
         }
-        int count = 1 << m;
-        double error = integral(opt.genz_no, dn, count, opt.s_dim,
-                                alpha, beta, expected, opt.rmse, opt.verbose,
-                                opt.digital_shift);
-        cout << dec << m << "," << error << "," << log2(error) << endl;
+        if (!all_stored) {
+            DigitalNet<uint64_t> dn(dnid, opt.s_dim, opt.end_m);
+            if (!is_embedded(dn, dnid, opt.start_m)) {
+                cout << name << " is not embedded, nested mode can't be used"
+                     << endl;
+                return -1;
+            }
+            dn.setSeed(static_cast<uint64_t>(clock()));
+            if (opt.linearScramble) {
+                dn.linearScramble();
+            }
+            GrayCodeNet gc(dn);
+            GenzBinding genz(opt.genz_no, opt.s_dim, alpha, beta);
+            auto sum_range = [&genz](KahanLanes& sum, GrayCodeNet& cursor,
+                                     uint64_t n) {
+                genz_sum_points(sum, genz, cursor, n);
+            };
+            if (opt.rmse > 0) {
+                nested_rmse(gc, opt.start_m, opt.end_m, opt.rmse,
+                            opt.threads, opt.seed, expected, sum_range,
+                            &error[0]);
+            } else {
+                nested_sum(gc, opt.start_m, opt.end_m, opt.threads,
+                           sum_range, &error[0]);
+                for (int k = 0; k < levels; k++) {
+                    double count = exp2(opt.start_m + k);
+                    if (opt.verbose) {
+                        cout << "calculated = " << (error[k] / count) << endl;
+                    }
+                    error[k] = abs(expected - error[k] / count);
+                }
+            }
+            for (int k = 0; k < levels; k++) {
+                if (!stored[k]) {
+                    ResultKey key = result_key(opt, name, opt.s_dim,
+                                               opt.start_m + k);
+                    if (!store.add(key, expected, error[k])) {
+                        store.reportError();
+                    }
+                }
+            }
+            if (!store.flush()) {
+                store.reportError();
+            }
+        }
+        for (int k = 0; k < levels; k++) {
+            cout << dec << (opt.start_m + k) << "," << error[k] << ","
+                 << log2(error[k]) << endl;
+        }
+        return 0;
     }
-    return 0;
-}
 
-namespace {
     int file_genz(cmd_opt_t& opt)
     {
+        if (is_net_file(opt.dnfile)) {
+            NetFile file;
+            if (!file.open(opt.dnfile)) {
+                cout << file.errorMessage() << endl;
+                return -1;
+            }
+            if (opt.linearScramble) {
+                cout << "linear scramble can't be used"
+                     << " with binary digital_net_file" << endl;
+                return -1;
+            }
+            ResultStore store;
+            if (!open_store(store, opt)) {
+                return -1;
+            }
+            GrayCodeNet dn(file.getS(), file.getM(), file.getBase());
+            dn.setSeed(opt.num_process > 1 ? opt.seed
+                       : static_cast<uint64_t>(clock()));
+            dn.pointInitialize();
+            if (file_genz_net(opt, store, dn) != 0) {
+                return -1;
+            }
+            return close_store(store);
+        }
         ifstream dnstream(opt.dnfile);
         if (!dnstream) {
             cout << "can't open digital_net_file" << endl;
             return -1;
         }
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
         DigitalNet<uint64_t> dn(dnstream);
-        dn.setSeed(static_cast<uint64_t>(clock()));
+        dn.setSeed(opt.num_process > 1 ? opt.seed
+                   : static_cast<uint64_t>(clock()));
         if (opt.linearScramble) {
             dn.linearScramble();
         }
@@ -129,18 +404,26 @@ namespace {
 #if defined(DEBUG) && 0
         dn.showStatus(cout);
 #endif
+        if (file_genz_net(opt, store, dn) != 0) {
+            return -1;
+        }
+        return close_store(store);
+    }
+
+    /**
+     * the rest of file_genz() for digital net from text file or
+     * binary file.
+     */
+    template<typename D>
+    int file_genz_net(cmd_opt_t& opt, ResultStore& store, D& dn)
+    {
         int s = dn.getS();
         int m = dn.getM();
-        double a[s];
-        double b[s];
-        double alpha[s];
-        double beta[s];
-        for (int i = 0; i < s; i++) {
-            a[i] = 0;
-            b[i] = 0;
-            alpha[i] = 0;
-            beta[i] = 0;
-        }
+        Workspace work;
+        double *a = work.alloc(s);
+        double *b = work.alloc(s);
+        double *alpha = work.alloc(s);
+        double *beta = work.alloc(s);
         double expected = 1.0;
         if (opt.wafom) {
             makeWafomParameter(opt.genz_no, opt.s_dim, opt.seed,
@@ -166,29 +449,223 @@ namespace {
         } else {
             cout << "#m, abs err, log2(err)" << endl;
         }
-        int count = 1 << m;
-        double error = integral(opt.genz_no, dn, count, s,
-                                alpha, beta, expected, opt.rmse, opt.verbose,
-                                opt.digital_shift);
+        ResultKey key = result_key(opt, opt.dnfile, s, m);
+        double error;
+        if (find_result(opt, store, key, &error)) {
+            cout << dec << m << "," << error << "," << log2(error) << endl;
+            return 0;
+        }
+        if (opt.num_process > 1) {
+#if defined(HAVE_MPI_H)
+            GrayCodeNet gc(dn);
+            gc.setSeed(opt.seed);
+            error = integral_mpi(opt, gc, m, s, alpha, beta, expected);
+#endif
+        } else if (opt.threads > 1 || opt.rmse > 0) {
+            uint64_t count = UINT64_C(1) << m;
+            GrayCodeNet gc(dn);
+            gc.setSeed(opt.seed);
+            error = integral_parallel(opt.genz_no, gc, count, s,
+                                      alpha, beta, expected, opt.rmse,
+                                      opt.verbose, opt.digital_shift,
+                                      opt.threads, opt.seed);
+        } else {
+            uint64_t count = UINT64_C(1) << m;
+            error = integral(opt.genz_no, dn, count, s,
+                             alpha, beta, expected, opt.rmse, opt.verbose,
+                             opt.digital_shift);
+        }
+        if (!store.add(key, expected, error) || !store.flush()) {
+            store.reportError();
+        }
         cout << dec << m << "," << error << "," << log2(error) << endl;
         return 0;
     }
 
+    /**
+     * evaluate the genz functions of genz_list by every digital net of
+     * a directory or a manifest and print one table.
+     * io_threads read the nets ahead of the computation, at most
+     * prefetch nets wait in the queue, and threads compute the
+     * integrals of different nets at the same time.
+     */
+    int batch_genz(cmd_opt_t& opt)
+    {
+        vector<string> files;
+        string message;
+        if (!list_net_files(opt.dnfile, files, message)) {
+            cout << message << endl;
+            return -1;
+        }
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
+        mutex store_mutex;
+        size_t genz_count = opt.genz_list.size();
+        vector<batch_result_t> results(files.size() * genz_count);
+        BoundedQueue<batch_net_t> queue(opt.prefetch, opt.io_threads);
+        atomic<size_t> next(0);
+        vector<thread> readers;
+        for (int i = 0; i < opt.io_threads; i++) {
+            readers.push_back(thread([&]() {
+                        for (;;) {
+                            size_t index = next++;
+                            if (index >= files.size()) {
+                                break;
+                            }
+                            batch_net_t net;
+                            net.index = index;
+                            net.s = 0;
+                            net.m = 0;
+                            if (!read_net_file(files[index], &net.s, &net.m,
+                                               net.mat, net.message)) {
+                                net.mat.clear();
+                            }
+                            queue.push(std::move(net));
+                        }
+                        queue.close();
+                    }));
+        }
+        vector<thread> workers;
+        for (int i = 0; i < opt.threads; i++) {
+            workers.push_back(thread([&]() {
+                        batch_net_t net;
+                        while (queue.pop(net)) {
+                            batch_evaluate(opt, store, store_mutex,
+                                           files[net.index], net,
+                                           &results[net.index * genz_count]);
+                        }
+                    }));
+        }
+        for (size_t i = 0; i < readers.size(); i++) {
+            readers[i].join();
+        }
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+        cout << "# batch = " << opt.dnfile << endl;
+        cout << "# nets = " << dec << files.size() << endl;
+        if (opt.rmse > 0) {
+            cout << "#genz_no, filename, s, m, abs err, log2(RMSE["
+                 << dec << opt.rmse << "])" << endl;
+        } else {
+            cout << "#genz_no, filename, s, m, abs err, log2(err)" << endl;
+        }
+        int status = 0;
+        for (size_t i = 0; i < files.size(); i++) {
+            for (size_t k = 0; k < genz_count; k++) {
+                const batch_result_t& r = results[i * genz_count + k];
+                if (!r.message.empty()) {
+                    cout << "# " << files[i] << ": " << r.message << endl;
+                    status = -1;
+                    break;
+                }
+                cout << dec << opt.genz_list[k] << "," << files[i] << ","
+                     << r.s << "," << r.m << "," << r.error << ","
+                     << log2(r.error) << endl;
+            }
+        }
+        if (close_store(store) != 0) {
+            status = -1;
+        }
+        return status;
+    }
+
+    /**
+     * evaluate the genz functions of genz_list by a net of batch mode.
+     * The parameters are made for the dimension of the net, and the
+     * digital shift is made from seed as in --threads, so that the
+     * table does not depend on the order of the computation.
+     */
+    void batch_evaluate(const cmd_opt_t& opt, ResultStore& store,
+                        mutex& store_mutex, const string& name,
+                        batch_net_t& net, batch_result_t result[])
+    {
+        int s = net.s;
+        int m = net.m;
+        for (size_t k = 0; k < opt.genz_list.size(); k++) {
+            result[k].s = s;
+            result[k].m = m;
+            result[k].error = 0;
+            result[k].message = net.message;
+        }
+        if (!net.message.empty()) {
+            return;
+        }
+        if (opt.s_dim > 0 && static_cast<uint32_t>(s) != opt.s_dim) {
+            result[0].message = "s_dim != dn.getS()";
+            return;
+        }
+        GrayCodeNet gc(s, m, &net.mat[0]);
+        net.mat.clear();
+        vector<double> a(s);
+        vector<double> b(s);
+        vector<double> alpha(s);
+        vector<double> beta(s);
+        for (size_t k = 0; k < opt.genz_list.size(); k++) {
+            cmd_opt_t genz_opt = opt;
+            genz_opt.genz_no = opt.genz_list[k];
+            ResultKey key = result_key(genz_opt, name, s, m);
+            double stored;
+            bool found;
+            {
+                lock_guard<mutex> lock(store_mutex);
+                found = store.find(key, &stored, &result[k].error);
+            }
+            if (found) {
+                continue;
+            }
+            double expected;
+            if (opt.wafom) {
+                makeWafomParameter(genz_opt.genz_no, s, opt.seed,
+                                   &a[0], &b[0], &alpha[0], &beta[0],
+                                   false, opt.mag);
+                expected = genz_integral(genz_opt.genz_no, s, &a[0], &b[0],
+                                         &alpha[0], &beta[0]);
+            } else if (opt.adjust) {
+                makeParameter(genz_opt.genz_no, s, opt.seed, opt.original,
+                              &a[0], &b[0], &alpha[0], &beta[0], false,
+                              opt.difficulty);
+                expected = adjustParameter(genz_opt.genz_no, s, &a[0], &b[0],
+                                           &alpha[0], &beta[0], false);
+            } else {
+                makeParameter(genz_opt.genz_no, s, opt.seed, opt.original,
+                              &a[0], &b[0], &alpha[0], &beta[0], false,
+                              opt.difficulty);
+                expected = genz_integral(genz_opt.genz_no, s, &a[0], &b[0],
+                                         &alpha[0], &beta[0]);
+            }
+            gc.setSeed(opt.seed);
+            gc.setDigitalShift(false);
+            gc.pointInitialize();
+            result[k].error = integral_parallel(genz_opt.genz_no, gc,
+                                                UINT64_C(1) << m,
+                                                s, &alpha[0], &beta[0],
+                                                expected, opt.rmse, false,
+                                                opt.digital_shift, 1,
+                                                opt.seed);
+            lock_guard<mutex> lock(store_mutex);
+            if (!store.add(key, expected, result[k].error) || !store.flush()) {
+                store.reportError();
+            }
+        }
+    }
+
     int random_genz(cmd_opt_t& opt)
     {
         int s = opt.s_dim;
+        ResultStore store;
+        if (!open_store(store, opt)) {
+            return -1;
+        }
         RandomNet dn(s, 100);
         dn.pointInitialize();
-        double a[s];
-        double b[s];
-        double alpha[s];
-        double beta[s];
-        for (int i = 0; i < s; i++) {
-            a[i] = 0;
-            b[i] = 0;
-            alpha[i] = 0;
-            beta[i] = 0;
-        }
+        Workspace work;
+        double *a = work.alloc(s);
+        double *b = work.alloc(s);
+        double *alpha = work.alloc(s);
+        double *beta = work.alloc(s);
         double expected = 1.0;
         if (opt.wafom) {
             makeWafomParameter(opt.genz_no, opt.s_dim, opt.seed,
@@ -225,13 +702,24 @@ namespace {
             if (opt.dn_id >= 101) {
                 dn.setMask(m);
             }
-            int count = 1 << m;
-            double error = integral(opt.genz_no, dn, count, opt.s_dim,
-                                    alpha, beta, expected, opt.rmse,
-                                    opt.verbose, opt.digital_shift);
+            ResultKey key = result_key(opt, opt.dn_id >= 101
+                                       ? "Random mask" : "Random", s, m);
+            double stored;
+            double error;
+            if (store.find(key, &stored, &error)) {
+                cout << dec << m << "," << error << "," << log2(error) << endl;
+                continue;
+            }
+            uint64_t count = UINT64_C(1) << m;
+            error = integral(opt.genz_no, dn, count, opt.s_dim,
+                             alpha, beta, expected, opt.rmse,
+                             opt.verbose, opt.digital_shift);
+            if (!store.add(key, expected, error) || !store.flush()) {
+                store.reportError();
+            }
             cout << dec << m << "," << error << "," << log2(error) << endl;
         }
-    return 0;
+        return close_store(store);
     }
 
     void cmd_message(const string& pgm)
@@ -239,9 +727,38 @@ namespace {
         cout << pgm << " -s s_dim -m start_m -M end_m -S seed -g genz_no"
              << " [-d digitalnet_id] [-D difficulty]"
              << " [-o] [-v] [-z] [-a]"
-             << " [-w mag] [-L]"
+             << " [-w mag] [-L] [-j threads] [-b database] [-n]"
+             << " [-B [-I io_threads] [-P prefetch]]"
              << " [digitalnet_file]"
              << endl;
+        cout << "\t--rmse, -r\t\tRMSE of rmse replicas digitally shifted"
+             << endl;
+        cout << "\t--threads, -j\t\tsplit points or RMSE replicas of"
+             << " digital net" << endl
+             << "\t\t\t\tamong threads, digital shift is made from seed"
+             << endl;
+        cout << "\t--db, -b\t\tsqlite3 database to store results,"
+             << " configurations" << endl
+             << "\t\t\t\talready in it are not computed again" << endl;
+        cout << "\t--nested, -n\t\tsum 2^end_m points once and print"
+             << " the error" << endl
+             << "\t\t\t\tat every power of two, needs embedded net"
+             << endl;
+        cout << "\t--batch, -B\t\tdigitalnet_file is a directory or a"
+             << " manifest of" << endl
+             << "\t\t\t\tnet files, genz_no can be a list like 1,3,5,"
+             << endl
+             << "\t\t\t\tthreads evaluate different nets" << endl;
+        cout << "\t--io-threads, -I\tthreads reading net files in batch"
+             << " mode, default 1" << endl;
+        cout << "\t--prefetch, -P\t\tnets read ahead in batch mode,"
+             << " default 4" << endl;
+#if defined(HAVE_MPI_H)
+        cout << "with mpirun -np N, the points of the net are split among"
+             << " N processes," << endl
+             << "each of them uses threads, digital shift is made from seed"
+             << endl;
+#endif
     }
 
     bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
@@ -265,6 +782,12 @@ namespace {
             {"verbose", no_argument, NULL, 'v'},
             {"linearScramble", no_argument, NULL, 'L'},
             {"adjust-parameter", no_argument, NULL, 'a'},
+            {"threads", required_argument, NULL, 'j'},
+            {"db", required_argument, NULL, 'b'},
+            {"nested", no_argument, NULL, 'n'},
+            {"batch", no_argument, NULL, 'B'},
+            {"io-threads", required_argument, NULL, 'I'},
+            {"prefetch", required_argument, NULL, 'P'},
             {NULL, 0, NULL, 0}};
         opt.s_dim = 0;
         opt.start_m = 0;
@@ -281,9 +804,16 @@ namespace {
         opt.wafom = false;
         opt.mag = 1.0;
         opt.linearScramble = false;
+        opt.threads = 1;
+        opt.nested = false;
+        opt.batch = false;
+        opt.io_threads = 1;
+        opt.rank = 0;
+        opt.num_process = 1;
+        opt.prefetch = 4;
         errno = 0;
         for (;;) {
-            c = getopt_long(argc, argv, "s:m:M:S:g:d:r:D:w:o::vLaxz:",
+            c = getopt_long(argc, argv, "s:m:M:S:g:d:r:D:w:o::vLaxz:j:b:nBI:P:",
                             longopts, NULL);
             if (error) {
                 break;
@@ -320,13 +850,25 @@ namespace {
                     error = true;
                 }
                 break;
-            case 'g':
-                opt.genz_no = strtoul(optarg, NULL, 10);
-                if (errno) {
-                    cout << "genz_no should be a number" << endl;
-                    error = true;
+            case 'g': {
+                opt.genz_list.clear();
+                char *p = optarg;
+                for (;;) {
+                    char *end;
+                    opt.genz_list.push_back(strtoul(p, &end, 10));
+                    if (errno || end == p || (*end != ',' && *end != 0)) {
+                        cout << "genz_no should be a number" << endl;
+                        error = true;
+                        break;
+                    }
+                    if (*end == 0) {
+                        break;
+                    }
+                    p = end + 1;
                 }
+                opt.genz_no = opt.genz_list[0];
                 break;
+            }
             case 'd':
                 opt.dn_id = strtoul(optarg, NULL, 10);
                 if (errno) {
@@ -383,6 +925,36 @@ namespace {
                     error = true;
                 }
                 break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'b':
+                opt.dbfile = optarg;
+                break;
+            case 'n':
+                opt.nested = true;
+                break;
+            case 'B':
+                opt.batch = true;
+                break;
+            case 'I':
+                opt.io_threads = strtol(optarg, NULL, 10);
+                if (errno || opt.io_threads < 1) {
+                    cout << "io_threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'P':
+                opt.prefetch = strtol(optarg, NULL, 10);
+                if (errno || opt.prefetch < 1) {
+                    cout << "prefetch should be a positive number" << endl;
+                    error = true;
+                }
+                break;
             case 'v':
                 opt.verbose = true;
                 break;
@@ -398,6 +970,28 @@ namespace {
                 break;
             }
         }
+        if (opt.nested && (opt.dn_id < 0 || opt.dn_id >= 100)) {
+            cout << "nested mode needs digitalnet_id of an embedded net"
+                 << endl;
+            error = true;
+        }
+        if (opt.nested && opt.digital_shift > 0) {
+            cout << "nested mode can't be used with digital shift" << endl;
+            error = true;
+        }
+        if (opt.genz_list.empty()) {
+            opt.genz_list.push_back(opt.genz_no);
+        }
+        if (opt.genz_list.size() > 1 && !opt.batch) {
+            cout << "list of genz_no needs batch mode" << endl;
+            error = true;
+        }
+        if (opt.batch && (opt.dn_id >= 0 || opt.nested
+                          || opt.linearScramble)) {
+            cout << "batch mode can't be used with digitalnet_id,"
+                 << " nested mode or linear scramble" << endl;
+            error = true;
+        }
         if (error) {
             cmd_message(pgm);
             return false;
@@ -419,8 +1013,121 @@ namespace {
         return true;
     }
 
+    /**
+     * true if the scramble or the digital shift of the run is made from
+     * clock(), then the results can't be reproduced.
+     */
+    bool clock_seeded(const cmd_opt_t& opt)
+    {
+        if (opt.batch || opt.dn_id >= 100) {
+            return false;
+        }
+        if (opt.nested) {
+            return opt.linearScramble;
+        }
+        if (opt.num_process > 1) {
+            return false;
+        }
+        return opt.linearScramble
+            || (opt.digital_shift > 0 && opt.threads <= 1 && opt.rmse == 0);
+    }
+
+    /**
+     * open the result database if it is specified. Results seeded by
+     * clock() are not stored, as they would be skipped by later runs
+     * as if they were reproducible.
+     */
+    bool open_store(ResultStore& store, const cmd_opt_t& opt)
+    {
+        if (opt.dbfile.empty()) {
+            return true;
+        }
+        if (clock_seeded(opt)) {
+            cout << "#results are not stored, they are seeded by clock()"
+                 << endl;
+            return true;
+        }
+        int ok = 1;
+        // with MPI, only rank 0 uses the database
+        if (opt.rank == 0 && !store.open(opt.dbfile)) {
+            cout << "can't open database " << opt.dbfile << ": "
+                 << store.errorMessage() << endl;
+            ok = 0;
+        }
+#if defined(HAVE_MPI_H)
+        if (opt.num_process > 1) {
+            MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        }
+#endif
+        return ok != 0;
+    }
+
+    /**
+     * commit the results and close the database.
+     * @return 0, or -1 if the results couldn't be stored
+     */
+    int close_store(ResultStore& store)
+    {
+        if (!store.close()) {
+            store.reportError();
+            return -1;
+        }
+        return 0;
+    }
+
+    /**
+     * find the error of key in the database. With MPI, rank 0 finds it
+     * and tells other ranks, so that all ranks skip the same
+     * configurations.
+     */
+    bool find_result(const cmd_opt_t& opt, ResultStore& store,
+                     const ResultKey& key, double *error)
+    {
+        double stored;
+        double found[2] = {0, 0};
+        if (store.find(key, &stored, error)) {
+            found[0] = 1;
+            found[1] = *error;
+        }
+#if defined(HAVE_MPI_H)
+        if (opt.num_process > 1) {
+            MPI_Bcast(found, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+            *error = found[1];
+        }
+#else
+        (void)opt;
+#endif
+        return found[0] != 0;
+    }
+
+    /**
+     * key of the row of the result database, options other than the key
+     * columns which change the result are kept in params.
+     */
+    ResultKey result_key(const cmd_opt_t& opt, const string& net, int s,
+                         int m)
+    {
+        ResultKey key;
+        key.program = "testpack_digitalnet";
+        key.net = net;
+        key.s = s;
+        key.m = m;
+        key.genz_no = opt.genz_no;
+        key.seed = opt.seed;
+        key.shift = opt.digital_shift;
+        ostringstream params;
+        params << "original=" << opt.original
+               << " difficulty=" << opt.difficulty
+               << " rmse=" << opt.rmse
+               << " wafom=" << (opt.wafom ? opt.mag : 0)
+               << " adjust=" << opt.adjust
+               << " scramble=" << opt.linearScramble;
+        key.params = params.str();
+        return key;
+    }
+
     template<typename D>
-    double integral(int func_index, D& digitalNet, int count, int dim,
+    double integral(int func_index, D& digitalNet, uint64_t count, int dim,
                     double alpha[], double beta[], double expected, int rmse,
                     bool verbose, int digital_shift)
     {
@@ -434,16 +1141,13 @@ namespace {
             digitalNet.setDigitalShift(true);
             digitalNet.pointInitialize();
         }
+        GenzBinding genz(func_index, dim, alpha, beta);
         // RMSE　Root Mean Squared Error
         if (rmse > 0) {
             Kahan esum;
-            for (int z = 0; z < 100; z++) {
-                Kahan sum;
-                for (int i = 0; i < count; i++) {
-                    const double *tuple = digitalNet.getPoint();
-                    sum.add(genz_function(func_index, dim, tuple, alpha, beta));
-                    digitalNet.nextPoint();
-                }
+            for (int z = 0; z < rmse; z++) {
+                KahanLanes sum;
+                genz_sum_points(sum, genz, digitalNet, count);
                 double er = expected - sum.get() / count;
 #if defined(DEBUG)
                 cout << "expected = " << expected << endl;
@@ -453,17 +1157,13 @@ namespace {
                 digitalNet.setDigitalShift(true);
                 digitalNet.pointInitialize();
             }
-            return sqrt(esum.get() / 100);
+            return sqrt(esum.get() / rmse);
         } else {
-            Kahan sum;
+            KahanLanes sum;
             for (int i = 0; i < digital_shift -1; i++) {
                 digitalNet.nextPoint();
             }
-            for (int i = 0; i < count; i++) {
-                const double *tuple = digitalNet.getPoint();
-                sum.add(genz_function(func_index, dim, tuple, alpha, beta));
-                digitalNet.nextPoint();
-            }
+            genz_sum_points(sum, genz, digitalNet, count);
 #if defined(DEBUG)
             cout << "expected = " << expected << endl;
 #endif
@@ -473,4 +1173,106 @@ namespace {
             return abs(expected - sum.get() / count);
         }
     }
+
+    /**
+     * the same as integral(), but points are summed by threads.
+     * In RMSE mode, replicas are distributed among threads and
+     * every replica has its own digital shift made from seed.
+     */
+    double integral_parallel(int func_index, GrayCodeNet& net,
+                             uint64_t count, int dim, double alpha[],
+                             double beta[], double expected, int rmse,
+                             bool verbose, int digital_shift, int threads,
+                             uint64_t seed)
+    {
+        GenzBinding genz(func_index, dim, alpha, beta);
+        auto sum_range = [&genz](KahanLanes& sum, GrayCodeNet& cursor,
+                                 uint64_t n) {
+            genz_sum_points(sum, genz, cursor, n);
+        };
+        // RMSE　Root Mean Squared Error
+        if (rmse > 0) {
+            return parallel_rmse(net, count, rmse, threads, seed, expected,
+                                 sum_range);
+        } else {
+            uint64_t start = 0;
+            if (digital_shift > 0) {
+                net.setDigitalShift(true);
+                net.pointInitialize();
+                start = digital_shift - 1;
+            }
+            double sum = parallel_sum(net, start, count, threads, sum_range);
+            if (verbose) {
+                cout << "calculated = " << (sum / count) << endl;
+            }
+            return abs(expected - sum / count);
+        }
+    }
+
+#if defined(HAVE_MPI_H)
+    /**
+     * the same as integral_parallel() without RMSE, but the 2^m points
+     * are split into contiguous ranges of ranks, and each rank sums its
+     * range by threads. Rank 0 gathers the partial sums with their
+     * compensations and merges them in the order of ranks, so that the
+     * result depends on the numbers of ranks and threads, but not on the
+     * timing. Rank 0 prints the number of points per second of all
+     * ranks.
+     * @return error on rank 0, 0 on other ranks.
+     */
+    double integral_mpi(const cmd_opt_t& opt, GrayCodeNet& net, int m,
+                        int dim, double alpha[], double beta[],
+                        double expected)
+    {
+        GenzBinding genz(opt.genz_no, dim, alpha, beta);
+        auto sum_range = [&genz](KahanLanes& sum, GrayCodeNet& cursor,
+                                 uint64_t n) {
+            genz_sum_points(sum, genz, cursor, n);
+        };
+        uint64_t count = UINT64_C(1) << m;
+        uint64_t start = 0;
+        if (opt.digital_shift > 0) {
+            net.setDigitalShift(true);
+            net.pointInitialize();
+            start = opt.digital_shift - 1;
+        }
+        uint64_t chunk = count / opt.num_process;
+        uint64_t first = start + chunk * opt.rank;
+        uint64_t n = chunk;
+        if (opt.rank == opt.num_process - 1) {
+            n = count - chunk * opt.rank;
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+        double begin = MPI_Wtime();
+        KahanLanes partial;
+        parallel_sum_lanes(net, first, n, opt.threads, sum_range, partial);
+        double state[KahanLanes::state_size];
+        partial.save(state);
+        vector<double> all;
+        if (opt.rank == 0) {
+            all.resize(static_cast<size_t>(KahanLanes::state_size)
+                       * opt.num_process);
+        }
+        MPI_Gather(state, KahanLanes::state_size, MPI_DOUBLE,
+                   opt.rank == 0 ? &all[0] : NULL, KahanLanes::state_size,
+                   MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        if (opt.rank != 0) {
+            return 0;
+        }
+        KahanLanes total;
+        for (int r = 0; r < opt.num_process; r++) {
+            KahanLanes part;
+            part.load(&all[static_cast<size_t>(r) * KahanLanes::state_size]);
+            total.merge(part);
+        }
+        double elapsed = MPI_Wtime() - begin;
+        double sum = total.get();
+        cout << "#points/s = " << (count / elapsed) << " by "
+             << dec << opt.num_process << " ranks" << endl;
+        if (opt.verbose) {
+            cout << "calculated = " << (sum / count) << endl;
+        }
+        return abs(expected - sum / count);
+    }
+#endif
 }
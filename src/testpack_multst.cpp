@@ -0,0 +1,148 @@
+#include <cerrno>
+#include <getopt.h>
+#include <cstdlib>
+#include <string>
+#include <iostream>
+#include "testpack.h"
+
+using namespace std;
+
+/*
+ * run multst() of testpack for adapt() as MAIN of the original
+ * testpack.cpp, with the samples divided among threads. The output is
+ * the same as testpack_output.txt of the original for any number of
+ * threads, except the time stamps.
+ */
+namespace {
+    struct cmd_opt_t {
+        int nsamp;
+        int maxpts;
+        double rel_tol;
+        int threads;
+    };
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv);
+    void cmd_message(const string& pgm);
+}
+
+int main(int argc, char *argv[])
+{
+    cmd_opt_t opt;
+    if (!parse_opt(opt, argc, argv)) {
+        return -1;
+    }
+    const int ndiml = 5;
+    const int tstlim = 6;
+    const int tstmax = 6;
+    double difclt[tstmax] = {110.0, 600.0, 600.0, 100.0, 150.0, 100.0};
+    double expnts[tstmax] = {1.5, 2.0, 2.0, 1.0, 2.0, 2.0};
+    int ndims[ndiml] = {2, 3, 4, 6, 8};
+    int tstfns[tstlim] = {1, 2, 3, 4, 5, 6};
+
+    timestamp();
+    cout << "\n";
+    cout << "TESTPACK\n";
+    cout << "  C++ version\n";
+    cout << "\n";
+    cout << "  Call MULTST, which can test a routine that\n";
+    cout << "  is designed to estimate multidimensional\n";
+    cout << "  integrals, by numerical quadrature.\n";
+    cout << "\n";
+    cout << "  The routine to be tested here is called ADAPT.\n";
+    cout << "\n";
+    cout << "  The test integrands are Genz's standard set.\n";
+    cout << "\n";
+    cout << "  MULTST, ADAPT and the test integrands were\n";
+    cout << "  written in FORTRAN77 by Alan Genz.\n";
+
+    multst_parallel(opt.nsamp, tstlim, tstfns, tstmax, difclt,
+                    expnts, ndiml, ndims, "ADAPT", adapt, opt.rel_tol,
+                    opt.maxpts, opt.threads);
+
+    cout << "\n";
+    cout << "TESTPACK\n";
+    cout << "  Normal end of execution\n";
+    cout << "\n";
+    timestamp();
+    return 0;
+}
+
+namespace {
+    void cmd_message(const string& pgm)
+    {
+        cout << pgm << " [-n samples] [-x max_points] [-e rel_tol]"
+             << " [-j threads]" << endl;
+        cout << "\t--samples, -n\t\tsamples per test, default 20" << endl;
+        cout << "\t--max-points, -x\tmaximum integrand calls,"
+             << " default 10000" << endl;
+        cout << "\t--rel-tol, -e\t\trequested relative accuracy,"
+             << " default 1e-6" << endl;
+        cout << "\t--threads, -j\t\tthreads running the samples" << endl;
+    }
+
+    bool parse_opt(cmd_opt_t& opt, int argc, char **argv)
+    {
+        int c;
+        bool error = false;
+        string pgm = argv[0];
+        static struct option longopts[] = {
+            {"samples", required_argument, NULL, 'n'},
+            {"max-points", required_argument, NULL, 'x'},
+            {"rel-tol", required_argument, NULL, 'e'},
+            {"threads", required_argument, NULL, 'j'},
+            {NULL, 0, NULL, 0}};
+        opt.nsamp = 20;
+        opt.maxpts = 10000;
+        opt.rel_tol = 1.0e-6;
+        opt.threads = 1;
+        errno = 0;
+        for (;;) {
+            c = getopt_long(argc, argv, "n:x:e:j:", longopts, NULL);
+            if (error) {
+                break;
+            }
+            if (c == -1) {
+                break;
+            }
+            switch (c) {
+            case 'n':
+                opt.nsamp = strtol(optarg, NULL, 10);
+                if (errno || opt.nsamp < 1 || opt.nsamp > 30) {
+                    cout << "samples should be 1 <= samples <= 30" << endl;
+                    error = true;
+                }
+                break;
+            case 'x':
+                opt.maxpts = strtol(optarg, NULL, 10);
+                if (errno || opt.maxpts < 1) {
+                    cout << "max_points should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'e':
+                opt.rel_tol = strtod(optarg, NULL);
+                if (errno || opt.rel_tol <= 0) {
+                    cout << "rel_tol should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case 'j':
+                opt.threads = strtol(optarg, NULL, 10);
+                if (errno || opt.threads < 1) {
+                    cout << "threads should be a positive number" << endl;
+                    error = true;
+                }
+                break;
+            case '?':
+            default:
+                error = true;
+                break;
+            }
+        }
+        if (error) {
+            cmd_message(pgm);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+namespace MCQMCIntegration {
+
+    /**
+     * Fixed number of threads which run tasks in the order submitted.
+     */
+    class ThreadPool {
+    public:
+        /**
+         * @param threads number of threads, at least one thread is made.
+         */
+        explicit ThreadPool(int threads) {
+            stop = false;
+            running = 0;
+            if (threads < 1) {
+                threads = 1;
+            }
+            for (int i = 0; i < threads; i++) {
+                workers.push_back(std::thread([this]() { work(); }));
+            }
+        }
+        /**
+         * waits until all tasks are finished.
+         */
+        ~ThreadPool() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                stop = true;
+            }
+            wake.notify_all();
+            for (size_t i = 0; i < workers.size(); i++) {
+                workers[i].join();
+            }
+        }
+        void submit(const std::function<void()>& task) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                tasks.push_back(task);
+            }
+            wake.notify_one();
+        }
+        /**
+         * wait until all tasks submitted are finished.
+         */
+        void wait() {
+            std::unique_lock<std::mutex> lock(mutex);
+            idle.wait(lock, [this]() {
+                    return tasks.empty() && running == 0;
+                });
+        }
+        int size() const {
+            return static_cast<int>(workers.size());
+        }
+    private:
+        ThreadPool(const ThreadPool&);
+        ThreadPool& operator=(const ThreadPool&);
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()> > tasks;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        int running;
+        bool stop;
+
+        void work() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this]() {
+                            return stop || !tasks.empty();
+                        });
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = tasks.front();
+                    tasks.pop_front();
+                    running++;
+                }
+                task();
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    running--;
+                    if (tasks.empty() && running == 0) {
+                        idle.notify_all();
+                    }
+                }
+            }
+        }
+    };
+}
+
+#endif // THREAD_POOL_HPP
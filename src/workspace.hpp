@@ -0,0 +1,83 @@
+#pragma once
+#ifndef WORKSPACE_HPP
+#define WORKSPACE_HPP
+
+#include <inttypes.h>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+namespace MCQMCIntegration {
+
+    /**
+     * Arena of working arrays of doubles, used instead of variable length
+     * arrays on the stack, which overflow for large s.
+     *
+     * alloc() returns an array aligned to 64 bytes and set to zero,
+     * which is valid until reset() or the destruction of the workspace.
+     * reset() keeps the memory, so that a workspace reused for arrays of
+     * the same sizes allocates memory only the first time.
+     */
+    class Workspace {
+    public:
+        Workspace() {
+            used = 0;
+        }
+        /**
+         * @param n number of doubles
+         * @return n doubles set to zero
+         */
+        double * alloc(size_t n) {
+            size_t size = std::max<size_t>(1, (n + align - 1) / align) * align;
+            if (blocks.empty() || used + size > blocks.back().size) {
+                size_t last = blocks.empty() ? 0 : blocks.back().size;
+                addBlock(std::max(size, 2 * last));
+            }
+            double *p = blocks.back().data + used;
+            used += size;
+            std::fill(p, p + n, 0.0);
+            return p;
+        }
+        /**
+         * make all arrays free. Blocks are merged into one block,
+         * so that the next use fits in it.
+         */
+        void reset() {
+            if (blocks.size() > 1) {
+                size_t total = 0;
+                for (size_t i = 0; i < blocks.size(); i++) {
+                    total += blocks[i].size;
+                }
+                blocks.clear();
+                addBlock(total);
+            }
+            used = 0;
+        }
+    private:
+        Workspace(const Workspace&);
+        Workspace& operator=(const Workspace&);
+        // doubles in 64 bytes
+        static const size_t align = 64 / sizeof(double);
+        struct Block {
+            std::vector<double> storage;
+            double *data;
+            size_t size;
+        };
+        // deque does not move blocks when a block is added
+        std::deque<Block> blocks;
+        size_t used;
+
+        void addBlock(size_t size) {
+            blocks.push_back(Block());
+            Block& block = blocks.back();
+            block.storage.resize(size + align);
+            uintptr_t p = reinterpret_cast<uintptr_t>(&block.storage[0]);
+            size_t skip = (64 - p % 64) % 64 / sizeof(double);
+            block.data = &block.storage[skip];
+            block.size = size;
+            used = 0;
+        }
+    };
+}
+#endif // WORKSPACE_HPP